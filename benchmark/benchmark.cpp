@@ -0,0 +1,199 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+// Times the stages of network generation and annealing for a range of particle
+// and thread counts and writes one JSON record per stage:
+//
+//   voronoi-benchmark [--particles 300,1000] [--threads 1,2] [--iterations 1000] [--output results.json]
+//
+// Annealing runs with a tolerance of zero, so every mode performs exactly the
+// given number of iterations and the proposal rates are comparable.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "network-generator.hpp"
+#include "resource-usage.hpp"
+
+namespace
+{
+  std::vector<unsigned int> ParseList(std::string const &list)
+  {
+    std::vector<std::string> items;
+    boost::split(items, list, boost::is_any_of(","), boost::token_compress_on);
+    std::vector<unsigned int> values;
+    for (auto const &item : items)
+      if (!item.empty())
+        values.push_back(boost::lexical_cast<unsigned int>(item));
+    return values;
+  }
+
+  // Appends the statistics recorded since the last call as benchmark records and
+  // resets them. Annealing stages get the proposal rate of their mode.
+  void CollectRecords(NetworkGenerator &generator, unsigned int particles, unsigned int threads,
+                      boost::property_tree::ptree &records)
+  {
+    for (auto const &stage : generator.Statistics())
+    {
+      boost::property_tree::ptree record;
+      record.put("stage", stage.name);
+      record.put("particles", particles);
+      record.put("threads", threads);
+      record.put("wall-seconds", stage.wallSeconds);
+      record.put("cpu-seconds", stage.cpuSeconds);
+      record.put("cpu-seconds-estimated", stage.cpuSecondsEstimated);
+      record.put("peak-rss-bytes", stage.peakRssBytes);
+      for (auto const &counter : stage.counters)
+        record.put("counters." + counter.first, counter.second);
+      if (stage.name == "annealing" && stage.wallSeconds > 0.0)
+      {
+        std::string mode = boost::lexical_cast<std::string>(stage.counters.at("mode"));
+        record.put("proposals-per-second",
+                   (stage.counters.at("proposals-move-1") + stage.counters.at("proposals-move-2")) / stage.wallSeconds);
+        record.put("stage", "annealing-mode-" + mode);
+      }
+      records.push_back(std::make_pair("", record));
+    }
+    generator.ClearStatistics();
+  }
+} // namespace
+
+int main(int argc, char const *argv[])
+{
+  std::vector<unsigned int> particleCounts = {300, 1000, 3000};
+  std::vector<unsigned int> threadCounts = {1};
+  unsigned int iterations = 1000;
+  std::string outputPath;
+
+  for (int i_arg = 1; i_arg < argc; ++i_arg)
+  {
+    std::string arg = argv[i_arg];
+    if (i_arg + 1 >= argc)
+    {
+      std::cerr << "Usage: " << argv[0]
+                << " [--particles 300,1000] [--threads 1,2] [--iterations 1000] [--output results.json]" << std::endl;
+      return 1;
+    }
+    std::string value = argv[++i_arg];
+    if (arg == "--particles")
+      particleCounts = ParseList(value);
+    else if (arg == "--threads")
+      threadCounts = ParseList(value);
+    else if (arg == "--iterations")
+      iterations = boost::lexical_cast<unsigned int>(value);
+    else if (arg == "--output")
+      outputPath = value;
+    else
+    {
+      std::cerr << "Unknown option " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("voronoi-benchmark-%%%%%%%%");
+  boost::filesystem::create_directories(directory);
+  std::string prefix = (directory / "network").string();
+
+  boost::property_tree::ptree records;
+  // the stages report their progress on std::cout, which would distort the timings
+  std::ostringstream discarded;
+  std::streambuf *coutBuffer = std::cout.rdbuf(discarded.rdbuf());
+  try
+  {
+    for (auto particles : particleCounts)
+      for (auto threads : threadCounts)
+      {
+        NetworkParameters parameters;
+        parameters.particles = particles;
+        parameters.parallelJobs = threads;
+        parameters.inputPrefix = prefix;
+        parameters.outputPrefix = prefix;
+        parameters.writeDiagnostics = false;
+        parameters.annealing.maxIter = iterations;
+        parameters.annealing.maxSubiter = 1;
+        parameters.annealing.tolerance = 0.0;
+        parameters.annealing.screenOutputEvery = iterations + 1;
+
+        NetworkGenerator generator;
+        generator.Configure(parameters);
+        generator.Generate();
+
+        for (auto binary : {false, true})
+        {
+          parameters.outputText = !binary;
+          parameters.outputBinary = binary;
+          generator.Configure(parameters);
+          generator.Write();
+          generator.Read();
+          boost::filesystem::remove(prefix + "_network.bin");
+        }
+
+        for (unsigned int mode : {1, 2})
+        {
+          parameters.annealing.mode = mode;
+          generator.Configure(parameters);
+          generator.Anneal();
+        }
+
+        CollectRecords(generator, particles, threads, records);
+      }
+  }
+  catch (...)
+  {
+    std::cout.rdbuf(coutBuffer);
+    boost::filesystem::remove_all(directory);
+    throw;
+  }
+  std::cout.rdbuf(coutBuffer);
+  boost::filesystem::remove_all(directory);
+
+  boost::property_tree::ptree results;
+  results.add_child("results", records);
+  // high-water mark of the whole run, the stages share one process
+  results.put("process-peak-rss-bytes", ProcessPeakRssBytes());
+  if (outputPath.empty())
+    boost::property_tree::write_json(std::cout, results);
+  else
+    boost::property_tree::write_json(outputPath, results);
+  return 0;
+}
@@ -0,0 +1,192 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef DIAGNOSTICS_WRITER_HPP
+#define DIAGNOSTICS_WRITER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./resource-usage.hpp"
+
+// Writes diagnostic files on a background thread. Callers hand over complete
+// chunks of data and return immediately; they only wait if more than
+// maxPendingBytes are still queued, which bounds the memory of the buffer.
+// All queued data is written and all files are closed on destruction.
+class DiagnosticsWriter
+{
+  enum class Operation
+  {
+    open,
+    openBinary,
+    write,
+    close
+  };
+
+  struct Task
+  {
+    Operation operation;
+    std::size_t file;
+    // path for open operations, data otherwise
+    std::string data;
+  };
+
+  std::size_t maxPendingBytes_;
+  std::size_t pendingBytes_ = 0;
+  std::size_t fileCount_ = 0;
+  std::deque<Task> tasks_;
+  bool stop_ = false;
+  // a task has been taken from the queue and is not finished yet
+  bool busy_ = false;
+  // CPU time of the writer thread up to its last finished task
+  double cpuSeconds_ = 0.0;
+  std::mutex mutex_;
+  std::condition_variable taskAvailable_;
+  std::condition_variable spaceAvailable_;
+  // signalled when a task is finished
+  std::condition_variable taskDone_;
+  // only accessed by the writer thread
+  std::vector<std::unique_ptr<std::ofstream>> files_;
+  std::thread writer_;
+
+public:
+  explicit DiagnosticsWriter(std::size_t maxPendingBytes = 64 << 20)
+      : maxPendingBytes_(maxPendingBytes), writer_([this]() { this->WriterLoop(); })
+  {
+  }
+
+  DiagnosticsWriter(DiagnosticsWriter const &) = delete;
+  DiagnosticsWriter &operator=(DiagnosticsWriter const &) = delete;
+
+  ~DiagnosticsWriter()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->stop_ = true;
+    }
+    this->taskAvailable_.notify_one();
+    this->writer_.join();
+  }
+
+  // Returns the handle used to write to the file at path.
+  std::size_t Open(std::string const &path, bool binary = false)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    std::size_t file = this->fileCount_++;
+    this->tasks_.push_back(Task{binary ? Operation::openBinary : Operation::open, file, path});
+    this->taskAvailable_.notify_one();
+    return file;
+  }
+
+  void Write(std::size_t file, std::string data)
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    // a chunk larger than the whole buffer is accepted once the queue is empty
+    this->spaceAvailable_.wait(lock, [this, &data]() {
+      return this->pendingBytes_ == 0 || this->pendingBytes_ + data.size() <= this->maxPendingBytes_;
+    });
+    this->pendingBytes_ += data.size();
+    this->tasks_.push_back(Task{Operation::write, file, std::move(data)});
+    this->taskAvailable_.notify_one();
+  }
+
+  void Close(std::size_t file)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->tasks_.push_back(Task{Operation::close, file, std::string()});
+    this->taskAvailable_.notify_one();
+  }
+
+  // Blocks until all queued tasks are finished and returns the CPU time the
+  // writer thread has spent so far.
+  double CpuSeconds()
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->taskDone_.wait(lock, [this]() { return this->tasks_.empty() && !this->busy_; });
+    return this->cpuSeconds_;
+  }
+
+private:
+  void WriterLoop()
+  {
+    while (true)
+    {
+      Task task;
+      {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->taskAvailable_.wait(lock, [this]() { return this->stop_ || !this->tasks_.empty(); });
+        if (this->tasks_.empty())
+          break;
+        task = std::move(this->tasks_.front());
+        this->tasks_.pop_front();
+        this->busy_ = true;
+      }
+
+      if (task.operation == Operation::open || task.operation == Operation::openBinary)
+      {
+        if (this->files_.size() <= task.file)
+          this->files_.resize(task.file + 1);
+        this->files_[task.file].reset(new std::ofstream(
+            task.data, task.operation == Operation::openBinary ? std::ios::out | std::ios::binary : std::ios::out));
+      }
+      else if (task.operation == Operation::write)
+      {
+        this->files_[task.file]->write(task.data.data(), task.data.size());
+        {
+          std::lock_guard<std::mutex> lock(this->mutex_);
+          this->pendingBytes_ -= task.data.size();
+        }
+        this->spaceAvailable_.notify_all();
+      }
+      else
+        this->files_[task.file].reset();
+
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->busy_ = false;
+        this->cpuSeconds_ = ThreadCpuSeconds();
+      }
+      this->taskDone_.notify_all();
+    }
+    this->files_.clear();
+  }
+};
+
+#endif
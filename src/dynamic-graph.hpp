@@ -0,0 +1,193 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef DYNAMIC_GRAPH_HPP
+#define DYNAMIC_GRAPH_HPP
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Undirected multigraph for connectivity edits during network generation. Edges
+// are stored contiguously and removed by moving the last edge into the gap, and
+// every edge knows its position in the incidence lists of both nodes, so adding,
+// removing and rewiring an edge keeps all incidence lists consistent in O(1).
+// Edge ids and the order of incidence lists change when edges are removed.
+class DynamicGraph
+{
+public:
+  typedef std::array<unsigned int, 2> Edge;
+
+  // Compacted graph without isolated nodes. Nodes are renumbered in their
+  // original order; the edges of node i are nodeEdgeIds[nodeEdgeOffsets[i]] to
+  // nodeEdgeIds[nodeEdgeOffsets[i + 1] - 1].
+  struct Compacted
+  {
+    std::vector<Edge> edges;
+    std::vector<std::size_t> nodeEdgeOffsets;
+    std::vector<unsigned int> nodeEdgeIds;
+    // new id of every old node, removed for isolated nodes
+    std::vector<unsigned int> newNodeIds;
+  };
+
+  static constexpr unsigned int removed = std::numeric_limits<unsigned int>::max();
+
+  DynamicGraph(std::size_t nodeCount, std::vector<Edge> const &edges) : nodeEdges_(nodeCount)
+  {
+    this->edges_.reserve(edges.size());
+    this->edgeSlots_.reserve(edges.size());
+    for (auto const &edge : edges)
+      this->AddEdge(edge[0], edge[1]);
+  }
+
+  std::size_t NodeCount() const
+  {
+    return this->nodeEdges_.size();
+  }
+
+  std::size_t EdgeCount() const
+  {
+    return this->edges_.size();
+  }
+
+  Edge const &EdgeNodes(unsigned int edge) const
+  {
+    return this->edges_[edge];
+  }
+
+  std::vector<Edge> const &Edges() const
+  {
+    return this->edges_;
+  }
+
+  std::size_t Degree(unsigned int node) const
+  {
+    return this->nodeEdges_[node].size();
+  }
+
+  // ids of the edges at the node, invalidated by any modification
+  std::vector<unsigned int> const &NodeEdges(unsigned int node) const
+  {
+    return this->nodeEdges_[node];
+  }
+
+  unsigned int AddEdge(unsigned int node1, unsigned int node2)
+  {
+    unsigned int edge = this->edges_.size();
+    this->edges_.push_back(Edge{{node1, node2}});
+    this->edgeSlots_.push_back({{0, 0}});
+    this->Attach(edge, 0);
+    this->Attach(edge, 1);
+    return edge;
+  }
+
+  // removes the edge and gives its id to the last edge
+  void RemoveEdge(unsigned int edge)
+  {
+    this->Detach(edge, 0);
+    this->Detach(edge, 1);
+
+    unsigned int last = this->edges_.size() - 1;
+    if (edge != last)
+    {
+      this->edges_[edge] = this->edges_[last];
+      this->edgeSlots_[edge] = this->edgeSlots_[last];
+      for (int end = 0; end < 2; ++end)
+        this->nodeEdges_[this->edges_[edge][end]][this->edgeSlots_[edge][end]] = edge;
+    }
+    this->edges_.pop_back();
+    this->edgeSlots_.pop_back();
+  }
+
+  // connects the given end of the edge to another node
+  void MoveEdgeEnd(unsigned int edge, int end, unsigned int node)
+  {
+    this->Detach(edge, end);
+    this->edges_[edge][end] = node;
+    this->Attach(edge, end);
+  }
+
+  Compacted Compact() const
+  {
+    Compacted compacted;
+    compacted.newNodeIds.assign(this->nodeEdges_.size(), removed);
+    compacted.nodeEdgeOffsets.reserve(this->nodeEdges_.size() + 1);
+    compacted.nodeEdgeOffsets.push_back(0);
+    compacted.nodeEdgeIds.reserve(2 * this->edges_.size());
+    for (unsigned int node = 0; node < this->nodeEdges_.size(); ++node)
+    {
+      if (this->nodeEdges_[node].empty())
+        continue;
+      compacted.newNodeIds[node] = compacted.nodeEdgeOffsets.size() - 1;
+      compacted.nodeEdgeIds.insert(compacted.nodeEdgeIds.end(), this->nodeEdges_[node].begin(), this->nodeEdges_[node].end());
+      compacted.nodeEdgeOffsets.push_back(compacted.nodeEdgeIds.size());
+    }
+
+    compacted.edges.reserve(this->edges_.size());
+    for (auto const &edge : this->edges_)
+      compacted.edges.push_back(Edge{{compacted.newNodeIds[edge[0]], compacted.newNodeIds[edge[1]]}});
+    return compacted;
+  }
+
+private:
+  void Attach(unsigned int edge, int end)
+  {
+    std::vector<unsigned int> &incident = this->nodeEdges_[this->edges_[edge][end]];
+    this->edgeSlots_[edge][end] = incident.size();
+    incident.push_back(edge);
+  }
+
+  void Detach(unsigned int edge, int end)
+  {
+    std::vector<unsigned int> &incident = this->nodeEdges_[this->edges_[edge][end]];
+    unsigned int slot = this->edgeSlots_[edge][end];
+    unsigned int moved = incident.back();
+    incident[slot] = moved;
+    incident.pop_back();
+    if (slot != incident.size())
+    {
+      // the moved entry was the last one of the list, find which end of the moved edge it belongs to
+      int movedEnd = (this->edges_[moved][0] == this->edges_[edge][end] && this->edgeSlots_[moved][0] == incident.size()) ? 0 : 1;
+      this->edgeSlots_[moved][movedEnd] = slot;
+    }
+  }
+
+  std::vector<Edge> edges_;
+  // position of every edge in the incidence lists of its two nodes
+  std::vector<std::array<unsigned int, 2>> edgeSlots_;
+  std::vector<std::vector<unsigned int>> nodeEdges_;
+};
+
+#endif
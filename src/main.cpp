@@ -33,15 +33,19 @@
  */
 
 
-#include "./config-loader.cpp"
+#include <iostream>
+
+#include "./network-generator.hpp"
 
 int main(int argc, char const *argv[])
 {
-    Voronoi voronoi = Voronoi();
-    ConfigLoader loader = ConfigLoader();
-    std::string configFilePath = argv[1];
-    loader.load(configFilePath);
-    loader.configure(voronoi);
-    voronoi.run();
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " config.json" << std::endl;
+        return 1;
+    }
+    NetworkGenerator generator = NetworkGenerator();
+    generator.ConfigureFromFile(argv[1]);
+    generator.Run();
     return 0;
 }
@@ -0,0 +1,102 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef NETWORK_FILE_HPP
+#define NETWORK_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/crc.hpp>
+
+// Layout of the binary network file "<prefix>_network.bin" (native byte order):
+//
+//   header      NetworkFile::Header
+//   section 0   vertex positions        double[3 * vertexCount]
+//   section 1   vertex orders           uint32[vertexCount]
+//   section 2   edges                   uint32[2 * edgeCount]
+//   section 3   node to edge offsets    uint64[vertexCount + 1]
+//   section 4   node to edge ids        uint32[nodeEdgeCount]
+//
+// The node to edge sections store the edges of node i in ids[offsets[i]] to
+// ids[offsets[i + 1] - 1] (CSR). Every section starts at an offset aligned to
+// 8 bytes so it can be used in place from a memory mapping. The header and
+// every section are protected by a CRC-32.
+namespace NetworkFile
+{
+  const char magic[8] = {'B', 'N', 'G', 'N', 'E', 'T', '\0', '\0'};
+  const std::uint32_t version = 1;
+  // written as is, so a file from a machine with different byte order is detected
+  const std::uint32_t byteOrderMark = 0x01020304;
+
+  enum Section
+  {
+    vertices = 0,
+    vertexOrders,
+    edges,
+    nodeEdgeOffsets,
+    nodeEdgeIds,
+    sectionCount
+  };
+
+  struct Header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint64_t vertexCount;
+    std::uint64_t edgeCount;
+    std::uint64_t nodeEdgeCount;
+    std::uint64_t sectionOffsets[sectionCount];
+    std::uint64_t sectionSizes[sectionCount];
+    std::uint32_t sectionChecksums[sectionCount];
+    // checksum of the header computed with this field set to zero
+    std::uint32_t headerChecksum;
+  };
+
+  static_assert(sizeof(Header) % 8 == 0, "Network file header must keep sections aligned.");
+
+  inline std::uint64_t AlignSection(std::uint64_t offset)
+  {
+    return (offset + 7) & ~static_cast<std::uint64_t>(7);
+  }
+
+  inline std::uint32_t Checksum(void const *data, std::size_t size)
+  {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+  }
+}
+
+#endif
@@ -0,0 +1,121 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#include "./network-generator.hpp"
+#include "./config-loader.cpp"
+
+NetworkGenerator::NetworkGenerator() : voronoi_(new Voronoi())
+{
+}
+
+NetworkGenerator::~NetworkGenerator() = default;
+NetworkGenerator::NetworkGenerator(NetworkGenerator &&) = default;
+NetworkGenerator &NetworkGenerator::operator=(NetworkGenerator &&) = default;
+
+void NetworkGenerator::Configure(NetworkParameters const &parameters)
+{
+  this->voronoi_->configure(parameters);
+}
+
+void NetworkGenerator::ConfigureFromFile(std::string const &configFilePath)
+{
+  ConfigLoader loader = ConfigLoader();
+  loader.load(configFilePath);
+  loader.configure(*this->voronoi_);
+}
+
+void NetworkGenerator::Generate()
+{
+  this->voronoi_->Generate();
+}
+
+void NetworkGenerator::Read()
+{
+  this->voronoi_->ReadGeometry();
+}
+
+void NetworkGenerator::Anneal()
+{
+  this->voronoi_->Anneal();
+}
+
+void NetworkGenerator::Write()
+{
+  this->voronoi_->OutputGeometry();
+}
+
+void NetworkGenerator::Run()
+{
+  this->voronoi_->run();
+}
+
+void NetworkGenerator::WriteReport() const
+{
+  this->voronoi_->WriteReport();
+}
+
+std::size_t NetworkGenerator::VertexCount() const
+{
+  return this->voronoi_->Vertices().size();
+}
+
+double const *NetworkGenerator::Vertices() const
+{
+  return reinterpret_cast<double const *>(this->voronoi_->Vertices().data());
+}
+
+unsigned int const *NetworkGenerator::VertexOrders() const
+{
+  return this->voronoi_->VertexOrders().data();
+}
+
+std::size_t NetworkGenerator::EdgeCount() const
+{
+  return this->voronoi_->Edges().size();
+}
+
+unsigned int const *NetworkGenerator::Edges() const
+{
+  return reinterpret_cast<unsigned int const *>(this->voronoi_->Edges().data());
+}
+
+std::vector<StageStatistics> const &NetworkGenerator::Statistics() const
+{
+  return this->voronoi_->Statistics();
+}
+
+void NetworkGenerator::ClearStatistics()
+{
+  this->voronoi_->ClearStatistics();
+}
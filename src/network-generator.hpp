@@ -0,0 +1,154 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef NETWORK_GENERATOR_HPP
+#define NETWORK_GENERATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Options for simulated annealing, see the "simulated-annealing" section of the
+// configuration file for their meaning.
+struct AnnealingParameters
+{
+  // 1, 2 or 3 for both movements
+  unsigned int mode = 1;
+  unsigned int maxIter = 5000;
+  unsigned int maxSubiter = 100;
+  double weightLine = 1.0;
+  double weightCosine = 1.0;
+  double tolerance = 0.1;
+  double temperatureInitial = 0.05;
+  double temperatureDecayRate = 0.95;
+  double maxMovementFrac = 0.05;
+  unsigned int screenOutputEvery = 1000;
+  unsigned int numBinsLength = 1000;
+  unsigned int numBinsCosine = 1000;
+  bool histogramBinary = false;
+};
+
+// Measurements of one computed stage, e.g. "tessellation" or "annealing".
+// CPU time is that of the thread computing the stage and of the threads it
+// starts, so that concurrent realisations do not count each other. Only the
+// additional OpenMP threads of the voro++ particle insertion are not counted,
+// which run only with parallel-jobs above one. Where one loop computes several
+// stages, its CPU time is split by wall time and marked as estimated. The peak resident set size is that of the process during the
+// stage on Linux, and the lifetime peak elsewhere; concurrent stages share it.
+// Counters hold stage specific sizes, event counts and results by name.
+struct StageStatistics
+{
+  std::string name;
+  double wallSeconds = 0.0;
+  double cpuSeconds = 0.0;
+  bool cpuSecondsEstimated = false;
+  double peakRssBytes = 0.0;
+  std::map<std::string, double> counters;
+};
+
+// Options for network generation, see the configuration file for their meaning.
+// Prefixes are used as given, i.e. relative to the working directory.
+struct NetworkParameters
+{
+  double seed = 1;
+  // batch mode seeds (empty for a single realisation)
+  std::vector<double> seeds;
+  // 0 uses all hardware threads
+  unsigned int parallelJobs = 0;
+  unsigned int particles = 300;
+  std::string inputPrefix;
+  std::string outputPrefix;
+  bool generate = true;
+  bool simulate = true;
+  bool outputText = true;
+  bool outputBinary = false;
+  // write annealing diagnostics (histograms, objective function) next to the output
+  bool writeDiagnostics = true;
+  std::array<double, 3> boxSize = {{1.0, 1.0, 1.0}};
+  std::array<double, 3> boxOrigin = {{0.0, 0.0, 0.0}};
+  AnnealingParameters annealing;
+  // parameter sweep variants (empty without sweep)
+  std::vector<AnnealingParameters> sweep;
+};
+
+class Voronoi;
+
+// In-process interface to network generation and simulated annealing. The
+// accessors return views of the internal arrays, which stay valid until the
+// next call modifying the network.
+class NetworkGenerator
+{
+  std::unique_ptr<Voronoi> voronoi_;
+
+public:
+  NetworkGenerator();
+  ~NetworkGenerator();
+  NetworkGenerator(NetworkGenerator &&);
+  NetworkGenerator &operator=(NetworkGenerator &&);
+
+  void Configure(NetworkParameters const &parameters);
+  // reads the parameters from a JSON configuration file like the voronoi executable
+  void ConfigureFromFile(std::string const &configFilePath);
+
+  // generates a new Voronoi network from the configured seed
+  void Generate();
+  // reads a network from the files at the configured input prefix
+  void Read();
+  // anneals the current network with the configured annealing parameters
+  void Anneal();
+  // writes the current network to the configured output prefix
+  void Write();
+  // complete run as done by the voronoi executable, including batch and sweep modes
+  void Run();
+  // writes the statistics of all stages to "<output-prefix>_report.json"
+  void WriteReport() const;
+
+  std::size_t VertexCount() const;
+  // x, y and z of every vertex
+  double const *Vertices() const;
+  // number of edges at every vertex
+  unsigned int const *VertexOrders() const;
+  std::size_t EdgeCount() const;
+  // ids of the two vertices of every edge
+  unsigned int const *Edges() const;
+
+  // measurements of all stages computed since construction or the last reset
+  std::vector<StageStatistics> const &Statistics() const;
+  void ClearStatistics();
+};
+
+#endif
@@ -0,0 +1,273 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef PERIODIC_CELL_LIST_HPP
+#define PERIODIC_CELL_LIST_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Set of ids below a fixed capacity with O(1) insertion, removal and access by
+// position, e.g. for drawing a random element.
+class IdBucket
+{
+  static constexpr unsigned int absent = std::numeric_limits<unsigned int>::max();
+
+  std::vector<unsigned int> ids_;
+  // position of every id in ids_, absent if not contained
+  std::vector<unsigned int> slots_;
+
+public:
+  explicit IdBucket(std::size_t capacity = 0) : slots_(capacity, absent)
+  {
+  }
+
+  bool Contains(unsigned int id) const
+  {
+    return this->slots_[id] != absent;
+  }
+
+  void Insert(unsigned int id)
+  {
+    if (this->Contains(id))
+      return;
+    this->slots_[id] = this->ids_.size();
+    this->ids_.push_back(id);
+  }
+
+  // moves the last id into the gap, so the order of the remaining ids changes
+  void Erase(unsigned int id)
+  {
+    if (!this->Contains(id))
+      return;
+    unsigned int slot = this->slots_[id];
+    this->ids_[slot] = this->ids_.back();
+    this->slots_[this->ids_[slot]] = slot;
+    this->ids_.pop_back();
+    this->slots_[id] = absent;
+  }
+
+  std::size_t Size() const
+  {
+    return this->ids_.size();
+  }
+
+  bool Empty() const
+  {
+    return this->ids_.empty();
+  }
+
+  unsigned int operator[](std::size_t position) const
+  {
+    return this->ids_[position];
+  }
+};
+
+// Ids of points in a periodic box, binned into cells a quarter of the search
+// radius wide, so the cells that can hold points within the radius of a
+// position approximate the sphere around it instead of covering whole slabs of
+// the box.
+class PeriodicCellList
+{
+  static constexpr unsigned int absent = std::numeric_limits<unsigned int>::max();
+  // number of cells per search radius along every axis
+  static constexpr int subdivisions = 4;
+
+  std::array<double, 3> lower_;
+  std::array<double, 3> size_;
+  double radius_;
+  std::array<int, 3> cellCounts_;
+  std::array<double, 3> cellWidths_;
+  std::vector<std::vector<unsigned int>> cells_;
+  // cell of every id and its position in that cell (absent if not contained)
+  std::vector<unsigned int> idCells_;
+  std::vector<unsigned int> idSlots_;
+
+public:
+  PeriodicCellList(std::array<double, 3> const &lower, std::array<double, 3> const &size,
+                   double radius, std::size_t capacity)
+      : lower_(lower), size_(size), radius_(radius), idCells_(capacity, 0), idSlots_(capacity, absent)
+  {
+    for (int dim = 0; dim < 3; ++dim)
+    {
+      this->cellCounts_[dim] = std::max(1, static_cast<int>(std::floor(size[dim] / radius * subdivisions)));
+      this->cellWidths_[dim] = size[dim] / this->cellCounts_[dim];
+    }
+    this->cells_.resize(this->cellCounts_[0] * this->cellCounts_[1] * this->cellCounts_[2]);
+  }
+
+  void Insert(unsigned int id, std::array<double, 3> const &position)
+  {
+    if (this->idSlots_[id] != absent)
+      return;
+    this->idCells_[id] = this->CellOf(position);
+    std::vector<unsigned int> &cell = this->cells_[this->idCells_[id]];
+    this->idSlots_[id] = cell.size();
+    cell.push_back(id);
+  }
+
+  // swap-remove, so the order of the remaining ids of the cell changes
+  void Erase(unsigned int id)
+  {
+    unsigned int slot = this->idSlots_[id];
+    if (slot == absent)
+      return;
+    std::vector<unsigned int> &cell = this->cells_[this->idCells_[id]];
+    cell[slot] = cell.back();
+    this->idSlots_[cell[slot]] = slot;
+    cell.pop_back();
+    this->idSlots_[id] = absent;
+  }
+
+  // Draws an id uniformly from those in the cells within the search radius of
+  // the position that are accepted by the predicate. Random draws are tried
+  // first; after maxTries rejections all candidates of these cells are
+  // enumerated, so the draw always terminates. Returns false if there is no
+  // acceptable id.
+  template <typename Engine, typename Predicate>
+  bool Draw(std::array<double, 3> const &position, Engine &gen, Predicate accept,
+            unsigned int &id, unsigned int maxTries = 64) const
+  {
+    std::vector<unsigned int> neighbourCells = this->NeighbourCells(position);
+    std::size_t candidateCount = 0;
+    for (auto cell : neighbourCells)
+      candidateCount += this->cells_[cell].size();
+    if (candidateCount == 0)
+      return false;
+
+    std::uniform_int_distribution<std::size_t> dis_candidate(0, candidateCount - 1);
+    for (unsigned int i_try = 0; i_try < maxTries; ++i_try)
+    {
+      std::size_t candidate = dis_candidate(gen);
+      for (auto cell : neighbourCells)
+      {
+        if (candidate < this->cells_[cell].size())
+        {
+          id = this->cells_[cell][candidate];
+          break;
+        }
+        candidate -= this->cells_[cell].size();
+      }
+      if (accept(id))
+        return true;
+    }
+
+    std::vector<unsigned int> accepted;
+    for (auto cell : neighbourCells)
+      for (std::size_t i = 0; i < this->cells_[cell].size(); ++i)
+        if (accept(this->cells_[cell][i]))
+          accepted.push_back(this->cells_[cell][i]);
+    if (accepted.empty())
+      return false;
+    id = accepted[std::uniform_int_distribution<std::size_t>(0, accepted.size() - 1)(gen)];
+    return true;
+  }
+
+private:
+  int CellIndex(int dim, double coordinate) const
+  {
+    int index = static_cast<int>(std::floor((coordinate - this->lower_[dim]) / this->size_[dim] * this->cellCounts_[dim]));
+    // wrap points slightly outside of the box and neighbours across the boundary
+    index %= this->cellCounts_[dim];
+    return index < 0 ? index + this->cellCounts_[dim] : index;
+  }
+
+  unsigned int CellOf(std::array<double, 3> const &position) const
+  {
+    return (this->CellIndex(2, position[2]) * this->cellCounts_[1] + this->CellIndex(1, position[1])) * this->cellCounts_[0] +
+           this->CellIndex(0, position[0]);
+  }
+
+  // cells that come closer to the position than the search radius, taking the
+  // nearest periodic image of each, and each listed once even if the radius
+  // spans the whole box
+  std::vector<unsigned int> NeighbourCells(std::array<double, 3> const &position) const
+  {
+    // distance of every cell offset along each axis, or a negative value if
+    // the offset is out of reach
+    std::array<std::vector<double>, 3> gaps;
+    std::array<int, 3> centre;
+    std::array<int, 3> reach;
+    for (int dim = 0; dim < 3; ++dim)
+    {
+      centre[dim] = this->CellIndex(dim, position[dim]);
+      reach[dim] = static_cast<int>(std::ceil(this->radius_ / this->cellWidths_[dim]));
+      double offset = position[dim] - this->lower_[dim] - centre[dim] * this->cellWidths_[dim];
+      offset -= std::floor(offset / this->size_[dim]) * this->size_[dim];
+      offset = std::min(std::max(offset, 0.0), this->cellWidths_[dim]);
+      gaps[dim].resize(2 * reach[dim] + 1);
+      for (int d = -reach[dim]; d <= reach[dim]; ++d)
+      {
+        double gap = 0.0;
+        if (d > 0)
+          gap = this->cellWidths_[dim] - offset + (d - 1) * this->cellWidths_[dim];
+        else if (d < 0)
+          gap = offset + (-d - 1) * this->cellWidths_[dim];
+        gaps[dim][d + reach[dim]] = gap;
+      }
+    }
+
+    double radius_squared = this->radius_ * this->radius_;
+    std::vector<unsigned int> cells;
+    for (int dz = -reach[2]; dz <= reach[2]; ++dz)
+    {
+      double gz = gaps[2][dz + reach[2]];
+      for (int dy = -reach[1]; dy <= reach[1]; ++dy)
+      {
+        double gy = gaps[1][dy + reach[1]];
+        if (gz * gz + gy * gy >= radius_squared)
+          continue;
+        for (int dx = -reach[0]; dx <= reach[0]; ++dx)
+        {
+          double gx = gaps[0][dx + reach[0]];
+          if (gz * gz + gy * gy + gx * gx >= radius_squared)
+            continue;
+          std::array<int, 3> index = {{centre[0] + dx, centre[1] + dy, centre[2] + dz}};
+          for (int dim = 0; dim < 3; ++dim)
+            index[dim] = (index[dim] % this->cellCounts_[dim] + this->cellCounts_[dim]) % this->cellCounts_[dim];
+          cells.push_back((index[2] * this->cellCounts_[1] + index[1]) * this->cellCounts_[0] + index[0]);
+        }
+      }
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    return cells;
+  }
+};
+
+#endif
@@ -0,0 +1,132 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef RANDOM_STREAM_HPP
+#define RANDOM_STREAM_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// Independent random number streams derived from the configured seed. Every
+// stage draws from its own stream, so its numbers do not depend on how many
+// numbers earlier stages consumed, and a stage running on several threads or
+// replicas gives each of them its own substream.
+enum RandomStream : std::uint32_t
+{
+  randomStreamGeneration = 1,
+  randomStreamConnectivity,
+  randomStreamAnnealing
+};
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers:
+// as easy as 1, 2, 3", SC 2011). The seed is the key, and the stream and substream
+// are the upper half of the 128 bit counter, so any (seed, stream, substream)
+// triple gives a sequence of 2^66 numbers independent of all others without
+// any jumping ahead. Satisfies UniformRandomBitGenerator.
+class RandomEngine
+{
+public:
+  typedef std::uint32_t result_type;
+
+  RandomEngine(std::uint64_t seed, std::uint32_t stream, std::uint32_t substream = 0)
+      : key_{{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)}},
+        counter_{{0, 0, stream, substream}}
+  {
+  }
+
+  static constexpr result_type min()
+  {
+    return 0;
+  }
+
+  static constexpr result_type max()
+  {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()()
+  {
+    if (this->index_ == 4)
+    {
+      this->output_ = Block(this->counter_, this->key_);
+      // 64 bit block counter in the lower half of the counter
+      if (++this->counter_[0] == 0)
+        ++this->counter_[1];
+      this->index_ = 0;
+    }
+    return this->output_[this->index_++];
+  }
+
+  void discard(unsigned long long count)
+  {
+    for (; count > 0 && this->index_ < 4; --count)
+      ++this->index_;
+    std::uint64_t blocks = count / 4;
+    std::uint64_t block = ((static_cast<std::uint64_t>(this->counter_[1]) << 32) | this->counter_[0]) + blocks;
+    this->counter_[0] = static_cast<std::uint32_t>(block);
+    this->counter_[1] = static_cast<std::uint32_t>(block >> 32);
+    for (count %= 4; count > 0; --count)
+      (*this)();
+  }
+
+private:
+  static std::array<std::uint32_t, 4> Block(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key)
+  {
+    std::uint64_t const multiplier0 = 0xD2511F53;
+    std::uint64_t const multiplier1 = 0xCD9E8D57;
+    std::uint32_t const weyl0 = 0x9E3779B9;
+    std::uint32_t const weyl1 = 0xBB67AE85;
+    for (int round = 0; round < 10; ++round)
+    {
+      std::uint64_t product0 = multiplier0 * counter[0];
+      std::uint64_t product1 = multiplier1 * counter[2];
+      counter = {{static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                  static_cast<std::uint32_t>(product1),
+                  static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                  static_cast<std::uint32_t>(product0)}};
+      key[0] += weyl0;
+      key[1] += weyl1;
+    }
+    return counter;
+  }
+
+  std::array<std::uint32_t, 2> key_;
+  std::array<std::uint32_t, 4> counter_;
+  std::array<std::uint32_t, 4> output_ = {{0, 0, 0, 0}};
+  // next unused word of output_, 4 if a new block is needed
+  unsigned int index_ = 4;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef RESOURCE_USAGE_HPP
+#define RESOURCE_USAGE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+
+// CPU time of the calling thread. Stages measure their own thread with it, so
+// that concurrent realisations or sweep variants do not count each other.
+inline double ThreadCpuSeconds()
+{
+  timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+    return 0.0;
+  return static_cast<double>(time.tv_sec) + 1e-9 * static_cast<double>(time.tv_nsec);
+}
+
+// Peak resident set size of the process since the last ResetPeakRss(), read
+// from VmHWM on Linux. Elsewhere it is the peak over the process lifetime.
+inline double PeakRssBytes()
+{
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  while (status >> key)
+  {
+    if (key == "VmHWM:")
+    {
+      double kilobytes = 0.0;
+      status >> kilobytes;
+      return kilobytes * 1024.0;
+    }
+    status.ignore(1 << 16, '\n');
+  }
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0.0;
+  // kilobytes on Linux
+  return static_cast<double>(usage.ru_maxrss) * 1024.0;
+}
+
+// Highest peak resident set size seen before any reset of the high-water mark.
+inline std::atomic<double> &RecordedPeakRssBytes()
+{
+  static std::atomic<double> peak(0.0);
+  return peak;
+}
+
+// Peak resident set size over the whole lifetime of the process.
+inline double ProcessPeakRssBytes()
+{
+  return std::max(RecordedPeakRssBytes().load(), PeakRssBytes());
+}
+
+// Resets the high-water mark of PeakRssBytes() to the current resident set
+// size, so that it measures the following stage. The mark is shared by the
+// whole process, so stages running concurrently reset it for each other. Where
+// the reset is not supported, PeakRssBytes() keeps the lifetime peak.
+inline void ResetPeakRss()
+{
+  double peak = PeakRssBytes();
+  std::atomic<double> &recorded = RecordedPeakRssBytes();
+  double previous = recorded.load();
+  while (previous < peak && !recorded.compare_exchange_weak(previous, peak))
+    ;
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  clearRefs << "5";
+}
+
+#endif
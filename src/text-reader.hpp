@@ -0,0 +1,181 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef TEXT_READER_HPP
+#define TEXT_READER_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "./thread-pool.hpp"
+
+// Whitespace separated numbers of a text file, stored row by row in one flat array.
+template <typename T>
+struct NumberRows
+{
+  std::vector<T> values;
+  // the values of row i are values[rowOffsets[i]] to values[rowOffsets[i + 1] - 1]
+  std::vector<std::size_t> rowOffsets = std::vector<std::size_t>(1, 0);
+
+  std::size_t RowCount() const
+  {
+    return this->rowOffsets.size() - 1;
+  }
+
+  std::size_t RowSize(std::size_t row) const
+  {
+    return this->rowOffsets[row + 1] - this->rowOffsets[row];
+  }
+
+  T const *Row(std::size_t row) const
+  {
+    return this->values.data() + this->rowOffsets[row];
+  }
+};
+
+// Parses the rows of the text range [begin, end), which starts at the beginning of
+// a line. Numbers are parsed with std::from_chars, i.e. independent of the locale.
+template <typename T>
+void ParseNumberRows(char const *begin, char const *end, bool skipEmptyRows, NumberRows<T> &rows)
+{
+  std::size_t lineCount = std::count(begin, end, '\n') + 1;
+  rows.rowOffsets.reserve(lineCount + 1);
+
+  char const *position = begin;
+  while (position < end)
+  {
+    char const *lineEnd = static_cast<char const *>(std::memchr(position, '\n', end - position));
+    if (lineEnd == nullptr)
+      lineEnd = end;
+
+    std::size_t rowBegin = rows.values.size();
+    while (true)
+    {
+      while (position < lineEnd && (*position == ' ' || *position == '\t' || *position == '\r'))
+        ++position;
+      if (position == lineEnd)
+        break;
+
+      T value;
+      std::from_chars_result result = std::from_chars(position, lineEnd, value);
+      if (result.ec != std::errc() || (result.ptr < lineEnd && *result.ptr != ' ' && *result.ptr != '\t' && *result.ptr != '\r'))
+        throw "Error in voronoi geometry loading: invalid number.";
+      rows.values.push_back(value);
+      position = result.ptr;
+    }
+
+    if (rows.values.size() != rowBegin || !skipEmptyRows)
+      rows.rowOffsets.push_back(rows.values.size());
+    position = lineEnd + 1;
+  }
+}
+
+// Reads all rows of numbers of a text file. The file is memory mapped, split into
+// line aligned chunks and the chunks are parsed concurrently on threadCount threads.
+// Lines without numbers are skipped if skipEmptyRows is set and kept as empty rows
+// otherwise.
+template <typename T>
+NumberRows<T> ReadNumberRows(std::string const &path, bool skipEmptyRows, unsigned int threadCount)
+{
+  NumberRows<T> rows;
+  if (!boost::filesystem::is_regular_file(path))
+    throw "Error in voronoi geometry loading: geometry file does not exist.";
+  if (boost::filesystem::file_size(path) == 0)
+    return rows;
+
+  boost::interprocess::file_mapping file(path.c_str(), boost::interprocess::read_only);
+  boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+  char const *data = static_cast<char const *>(region.get_address());
+  char const *dataEnd = data + region.get_size();
+
+  // line aligned chunks of at least 1 MiB
+  std::size_t const minChunkSize = 1 << 20;
+  std::size_t chunkCount = std::max<std::size_t>(1, std::min<std::size_t>(4 * threadCount, region.get_size() / minChunkSize));
+  std::vector<char const *> chunkBegins(1, data);
+  for (std::size_t i_chunk = 1; i_chunk < chunkCount; ++i_chunk)
+  {
+    char const *split = std::max(chunkBegins.back(), data + i_chunk * (region.get_size() / chunkCount));
+    split = static_cast<char const *>(std::memchr(split, '\n', dataEnd - split));
+    if (split == nullptr)
+      break;
+    chunkBegins.push_back(split + 1);
+  }
+  chunkBegins.push_back(dataEnd);
+
+  std::vector<NumberRows<T>> chunkRows(chunkBegins.size() - 1);
+  if (chunkRows.size() == 1 || threadCount <= 1)
+  {
+    for (std::size_t i_chunk = 0; i_chunk < chunkRows.size(); ++i_chunk)
+      ParseNumberRows(chunkBegins[i_chunk], chunkBegins[i_chunk + 1], skipEmptyRows, chunkRows[i_chunk]);
+  }
+  else
+  {
+    ThreadPool pool(std::min<std::size_t>(threadCount, chunkRows.size()));
+    for (std::size_t i_chunk = 0; i_chunk < chunkRows.size(); ++i_chunk)
+      pool.Submit([&, i_chunk]() {
+        ParseNumberRows(chunkBegins[i_chunk], chunkBegins[i_chunk + 1], skipEmptyRows, chunkRows[i_chunk]);
+      });
+    pool.Wait();
+  }
+
+  if (chunkRows.size() == 1)
+    return std::move(chunkRows[0]);
+
+  // concatenate the chunks in file order
+  std::size_t valueCount = 0;
+  std::size_t rowCount = 0;
+  for (auto const &chunk : chunkRows)
+  {
+    valueCount += chunk.values.size();
+    rowCount += chunk.RowCount();
+  }
+  rows.values.reserve(valueCount);
+  rows.rowOffsets.reserve(rowCount + 1);
+  for (auto const &chunk : chunkRows)
+  {
+    std::size_t valueOffset = rows.values.size();
+    rows.values.insert(rows.values.end(), chunk.values.begin(), chunk.values.end());
+    for (std::size_t i_row = 1; i_row < chunk.rowOffsets.size(); ++i_row)
+      rows.rowOffsets.push_back(valueOffset + chunk.rowOffsets[i_row]);
+  }
+  return rows;
+}
+
+#endif
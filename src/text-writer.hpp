@@ -0,0 +1,69 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef TEXT_WRITER_HPP
+#define TEXT_WRITER_HPP
+
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Appends the shortest decimal representation of value that reads back to
+// exactly the same double (std::to_chars without precision).
+inline void AppendNumber(std::string &buffer, double value)
+{
+  char digits[32];
+  std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+inline void AppendNumber(std::string &buffer, unsigned int value)
+{
+  char digits[16];
+  std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+// Writes the already formatted chunks to path, one block write per chunk.
+inline void WriteTextChunks(std::string const &path, std::vector<std::string> const &chunks)
+{
+  std::ofstream file(path, std::ios::out | std::ios::binary);
+  for (auto const &chunk : chunks)
+    file.write(chunk.data(), chunk.size());
+  if (!file)
+    throw "Error in geometry output: writing a text file failed.";
+}
+
+#endif
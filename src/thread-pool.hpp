@@ -0,0 +1,169 @@
+/* _________________________________________________________________________________
+ *
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, bionetgen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * _________________________________________________________________________________
+ */
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "./resource-usage.hpp"
+
+// Fixed size pool of worker threads executing queued tasks in submission order.
+class ThreadPool
+{
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  // signalled when a task is queued or the pool is shut down
+  std::condition_variable taskAvailable_;
+  // signalled when the last running task has finished
+  std::condition_variable tasksDone_;
+  unsigned int runningTasks_ = 0;
+  bool stop_ = false;
+  // first exception thrown by a task, rethrown in Wait()
+  std::exception_ptr error_;
+  // CPU time the workers have spent in finished tasks
+  double taskCpuSeconds_ = 0.0;
+
+public:
+  explicit ThreadPool(unsigned int threadCount = DefaultThreadCount())
+  {
+    if (threadCount == 0)
+      threadCount = 1;
+    this->workers_.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i)
+      this->workers_.emplace_back([this]() { this->WorkerLoop(); });
+  }
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->stop_ = true;
+    }
+    this->taskAvailable_.notify_all();
+    for (auto &worker : this->workers_)
+      worker.join();
+  }
+
+  static unsigned int DefaultThreadCount()
+  {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+  }
+
+  unsigned int Size() const
+  {
+    return this->workers_.size();
+  }
+
+  void Submit(std::function<void()> task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->tasks_.push(std::move(task));
+    }
+    this->taskAvailable_.notify_one();
+  }
+
+  // CPU time of all tasks finished so far, summed over the workers.
+  double TaskCpuSeconds()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->taskCpuSeconds_;
+  }
+
+  // Blocks until all submitted tasks are finished. If a task threw, the first
+  // exception is rethrown here after the remaining tasks have completed.
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->tasksDone_.wait(lock, [this]() { return this->tasks_.empty() && this->runningTasks_ == 0; });
+    if (this->error_)
+    {
+      std::exception_ptr error = this->error_;
+      this->error_ = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  void WorkerLoop()
+  {
+    while (true)
+    {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->taskAvailable_.wait(lock, [this]() { return this->stop_ || !this->tasks_.empty(); });
+        if (this->tasks_.empty())
+          return;
+        task = std::move(this->tasks_.front());
+        this->tasks_.pop();
+        ++this->runningTasks_;
+      }
+
+      double start_cpu = ThreadCpuSeconds();
+      try
+      {
+        task();
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (!this->error_)
+          this->error_ = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->taskCpuSeconds_ += ThreadCpuSeconds() - start_cpu;
+        --this->runningTasks_;
+        if (this->tasks_.empty() && this->runningTasks_ == 0)
+          this->tasksDone_.notify_all();
+      }
+    }
+  }
+};
+
+#endif
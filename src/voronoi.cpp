@@ -33,24 +33,49 @@
  */
 
 
+#include <array>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <cstring>
 #include <chrono>
 #include <map>
+#include <sstream>
+#include <memory>
 #include <set>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include "../voro++-0.4.6/src/voro++.hh"
+#include "./resource-usage.hpp"
+#include "./thread-pool.hpp"
+#include "./random-stream.hpp"
+#include "./periodic-cell-list.hpp"
+#include "./dynamic-graph.hpp"
+#include "./network-file.hpp"
+#include "./text-reader.hpp"
+#include "./text-writer.hpp"
+#include "./diagnostics-writer.hpp"
+#include "./network-generator.hpp"
 // #include "../lib/lib_vec.hpp"
 
 const double one_third = 1.0 / 3.0;
 
+// position of a point in space
+typedef std::array<double, 3> Point;
+// ids of the two vertices connected by an edge
+typedef std::array<unsigned int, 2> Edge;
+
+static_assert(sizeof(Point) == 3 * sizeof(double), "Vertex positions must be stored contiguously.");
+static_assert(sizeof(Edge) == 2 * sizeof(std::uint32_t), "Edges must be stored as pairs of 32 bit ids.");
+
 class Voronoi
 {
   bool generate_;
@@ -58,31 +83,40 @@ class Voronoi
   uint mode_;
   boost::filesystem::path outputPrefix_;
   boost::filesystem::path inputPrefix_;
+  // which geometry files OutputGeometry writes
+  bool outputText_;
+  bool outputBinary_;
+  // write annealing diagnostics next to the output
+  bool writeDiagnostics_;
   std::vector<double> boxSize_;
   std::vector<double> boxOrigin_;
   double seed_;
+  // seeds of independent realisations computed in batch mode (empty for a single run)
+  std::vector<double> seeds_;
+  // number of realisations computed concurrently in batch mode
+  unsigned int parallelJobs_;
   uint voronoiParticleCount_;
   uint currnumfils_;
   // position of center of particles
-  std::vector<std::vector<double>> particlePositions_ = std::vector<std::vector<double>>();
+  std::vector<Point> particlePositions_ = std::vector<Point>();
   // contains vertex id with its position
-  std::vector<std::vector<double>> vertices_ = std::vector<std::vector<double>>();
+  std::vector<Point> vertices_ = std::vector<Point>();
   // contains edges and the respective nodes it is attached to
-  std::vector<std::vector<unsigned int>> edges_ = std::vector<std::vector<unsigned int>>();
+  std::vector<Edge> edges_ = std::vector<Edge>();
   // contains order of a vertices
   std::vector<unsigned int> vertexEdgeCount_ = std::vector<unsigned int>();
   // nodes to edges (contains dead nodes)
   std::vector<std::vector<unsigned int>> node_to_edges_;
   // the following map does not contain dead nodes, i.e. nodes with z == 0
   // so in here only really existing nodes
-  std::map<unsigned int, std::vector<double>> vertices_map_;
+  std::map<unsigned int, Point> vertices_map_;
   // all really existing nodes with their respective edges
   std::map<unsigned int, std::vector<unsigned int>> edge_map_;
   // a vector containing all vertex ids of really existing verteces. Note
   // that index of vector is not equal to to node id
   std::vector<unsigned int> vertices_for_random_draw_;
   // shifted vertex positions
-  std::vector<std::vector<double>> vtxs_shifted_;
+  std::vector<Point> vtxs_shifted_;
   // contains all finite element node ids that belong to vertex
   std::vector<std::vector<unsigned int>> vertexNodeIds_ = std::vector<std::vector<unsigned int>>();
   // Input parameters for Simulated Annealing
@@ -98,77 +132,352 @@ class Voronoi
   // for binning
   unsigned int p_num_bins_lengths;
   unsigned int p_num_bins_cosines;
+  // write the cosine histograms as binary (bin centre, count) pairs instead of text
+  bool histogramBinary_;
+  // annealing parameters of every variant of a parameter sweep (empty without sweep)
+  std::vector<AnnealingParameters> sweepVariants_;
+  // measurements of all stages computed so far, in order of computation
+  std::vector<StageStatistics> statistics_;
 
 public:
   void configure(boost::filesystem::path config_path, boost::property_tree::ptree config)
   {
-    this->outputPrefix_ = boost::filesystem::path(config_path) / boost::filesystem::path(config.get<std::string>("output-prefix"));
-    if (this->outputPrefix_.has_parent_path())
-      if (!boost::filesystem::exists(this->outputPrefix_.parent_path()))
-        boost::filesystem::create_directory(this->outputPrefix_.parent_path());
-    this->inputPrefix_ = boost::filesystem::path(config_path) / boost::filesystem::path(config.get<std::string>("input-prefix"));
-    if (this->inputPrefix_.has_parent_path())
-      if (!boost::filesystem::exists(this->inputPrefix_.parent_path()))
-        boost::filesystem::create_directory(this->inputPrefix_.parent_path());
+    NetworkParameters parameters;
+    parameters.outputPrefix = (boost::filesystem::path(config_path) / boost::filesystem::path(config.get<std::string>("output-prefix"))).string();
+    parameters.inputPrefix = (boost::filesystem::path(config_path) / boost::filesystem::path(config.get<std::string>("input-prefix"))).string();
 
-    this->seed_ = config.get<double>("seed");
-    this->voronoiParticleCount_ = config.get<uint>("particles");
+    std::string output_format = config.get<std::string>("output-format", "text");
+    if (output_format != "text" && output_format != "binary" && output_format != "both")
+      throw "Invalid output-format. Can only be 'text', 'binary' or 'both'.";
+    parameters.outputText = output_format != "binary";
+    parameters.outputBinary = output_format != "text";
 
-    this->generate_ = config.get<bool>("generate");
-    this->simulate_ = config.get<bool>("simulate");
+    parameters.seed = config.get<double>("seed");
 
-    for (auto child : config.get_child("box-size"))
-      this->boxSize_.push_back(child.second.get_value<double>());
-    for (auto child : config.get_child("box-origin"))
-      this->boxOrigin_.push_back(child.second.get_value<double>());
+    // batch mode: either an explicit list of seeds or an inclusive range "first..last"
+    auto config_seeds = config.get_child_optional("seeds");
+    if (config_seeds)
+    {
+      if (config_seeds->empty())
+      {
+        std::string range = config_seeds->get_value<std::string>();
+        std::size_t separator = range.find("..");
+        if (separator == std::string::npos)
+          throw "Invalid seeds. Must be an array of seeds or a range 'first..last'.";
+        long first = boost::lexical_cast<long>(range.substr(0, separator));
+        long last = boost::lexical_cast<long>(range.substr(separator + 2));
+        if (last < first)
+          throw "Invalid seeds. The last seed of a range must not be smaller than the first.";
+        for (long seed = first; seed <= last; ++seed)
+          parameters.seeds.push_back(seed);
+      }
+      else
+        for (auto child : *config_seeds)
+          parameters.seeds.push_back(child.second.get_value<double>());
+    }
+    // 0 uses all hardware threads, as in NetworkParameters
+    parameters.parallelJobs = config.get<unsigned int>("parallel-jobs", 0);
+    parameters.particles = config.get<uint>("particles");
+
+    parameters.generate = config.get<bool>("generate");
+    parameters.simulate = config.get<bool>("simulate");
+
+    auto config_box_size = config.get_child("box-size");
+    if (config_box_size.size() != 3)
+      throw "Invalid box-size. Must be an array of exactly 3 entries.";
+    unsigned int dim = 0;
+    for (auto child : config_box_size)
+      parameters.boxSize[dim++] = child.second.get_value<double>();
+    auto config_box_origin = config.get_child("box-origin");
+    if (config_box_origin.size() != 3)
+      throw "Invalid box-origin. Must be an array of exactly 3 entries.";
+    dim = 0;
+    for (auto child : config_box_origin)
+      parameters.boxOrigin[dim++] = child.second.get_value<double>();
 
     // Simulated Annealing
     auto config_sa = config.get_child("simulated-annealing");
+    parameters.annealing = ParseAnnealing(config_sa);
+
+    // parameter sweep: every variant overrides some of the annealing parameters
+    auto config_sweep = config_sa.get_child_optional("sweep");
+    if (config_sweep)
+    {
+      boost::property_tree::ptree config_base = config_sa;
+      config_base.erase("sweep");
+      for (auto variant : *config_sweep)
+      {
+        boost::property_tree::ptree config_variant = config_base;
+        for (auto parameter : variant.second)
+          config_variant.put_child(parameter.first, parameter.second);
+        parameters.sweep.push_back(ParseAnnealing(config_variant));
+      }
+    }
+
+    this->configure(parameters);
+  }
+
+  static AnnealingParameters ParseAnnealing(boost::property_tree::ptree const &config_sa)
+  {
+    AnnealingParameters parameters;
     std::string mode = config_sa.get<std::string>("mode");
     if (mode == "1")
-      this->mode_ = 1;
+      parameters.mode = 1;
     else if (mode == "2")
-      this->mode_ = 2;
+      parameters.mode = 2;
     else if (mode == "both")
-      this->mode_ = 3;
+      parameters.mode = 3;
     else
       throw "Invalid mode. Can only be '1', '2' or 'both'.";
-    this->max_iter = config_sa.get<uint>("max-iter");
-    this->max_subiter = config_sa.get<uint>("max-subiter");
-    this->weight_line = config_sa.get<double>("weight-line");
-    this->weight_cosine = config_sa.get<double>("weight-cosine");
-    this->tolerance = config_sa.get<double>("tolerance");
-    this->temperature_inital = config_sa.get<double>("temperature-initial");
-    this->decay_rate_temperature = config_sa.get<double>("temperature-decay-rate");
-    const double max_movementFrac = config_sa.get<double>("max-movement-frac");
-    this->max_movement = max_movementFrac * this->boxSize_[0];
-    this->screen_output_every = config_sa.get<uint>("screen-output-every");
+    parameters.maxIter = config_sa.get<uint>("max-iter");
+    parameters.maxSubiter = config_sa.get<uint>("max-subiter");
+    parameters.weightLine = config_sa.get<double>("weight-line");
+    parameters.weightCosine = config_sa.get<double>("weight-cosine");
+    parameters.tolerance = config_sa.get<double>("tolerance");
+    parameters.temperatureInitial = config_sa.get<double>("temperature-initial");
+    parameters.temperatureDecayRate = config_sa.get<double>("temperature-decay-rate");
+    parameters.maxMovementFrac = config_sa.get<double>("max-movement-frac");
+    parameters.screenOutputEvery = config_sa.get<uint>("screen-output-every");
 
     // for binning
-    this->p_num_bins_lengths = config_sa.get<uint>("num-bins-length");
-    this->p_num_bins_cosines = config_sa.get<uint>("num-bins-cosine");
+    parameters.numBinsLength = config_sa.get<uint>("num-bins-length");
+    parameters.numBinsCosine = config_sa.get<uint>("num-bins-cosine");
+
+    std::string histogram_format = config_sa.get<std::string>("histogram-format", "text");
+    if (histogram_format != "text" && histogram_format != "binary")
+      throw "Invalid histogram-format. Can only be 'text' or 'binary'.";
+    parameters.histogramBinary = histogram_format == "binary";
+    return parameters;
+  }
+
+  void configure(NetworkParameters const &parameters)
+  {
+    this->outputPrefix_ = boost::filesystem::path(parameters.outputPrefix);
+    if (this->outputPrefix_.has_parent_path())
+      if (!boost::filesystem::exists(this->outputPrefix_.parent_path()))
+        boost::filesystem::create_directory(this->outputPrefix_.parent_path());
+    this->inputPrefix_ = boost::filesystem::path(parameters.inputPrefix);
+    if (this->inputPrefix_.has_parent_path())
+      if (!boost::filesystem::exists(this->inputPrefix_.parent_path()))
+        boost::filesystem::create_directory(this->inputPrefix_.parent_path());
+
+    this->outputText_ = parameters.outputText;
+    this->outputBinary_ = parameters.outputBinary;
+    this->writeDiagnostics_ = parameters.writeDiagnostics;
+    this->seed_ = parameters.seed;
+    this->seeds_ = parameters.seeds;
+    this->parallelJobs_ = parameters.parallelJobs == 0 ? ThreadPool::DefaultThreadCount() : parameters.parallelJobs;
+    if (parameters.particles < 6)
+      throw "Invalid particles. Must be greater than 5.";
+    this->voronoiParticleCount_ = parameters.particles;
+    this->generate_ = parameters.generate;
+    this->simulate_ = parameters.simulate;
+    this->boxSize_.assign(parameters.boxSize.begin(), parameters.boxSize.end());
+    this->boxOrigin_.assign(parameters.boxOrigin.begin(), parameters.boxOrigin.end());
+
+    // fail early on invalid variants
+    for (auto const &variant : parameters.sweep)
+      this->ConfigureAnnealing(variant);
+    this->sweepVariants_ = parameters.sweep;
+    this->ConfigureAnnealing(parameters.annealing);
+  }
+
+  void ConfigureAnnealing(AnnealingParameters const &parameters)
+  {
+    if (parameters.mode < 1 || parameters.mode > 3)
+      throw "Invalid mode. Can only be '1', '2' or 'both'.";
+    this->mode_ = parameters.mode;
+    this->max_iter = parameters.maxIter;
+    this->max_subiter = parameters.maxSubiter;
+    this->weight_line = parameters.weightLine;
+    this->weight_cosine = parameters.weightCosine;
+    this->tolerance = parameters.tolerance;
+    this->temperature_inital = parameters.temperatureInitial;
+    this->decay_rate_temperature = parameters.temperatureDecayRate;
+    this->max_movement = parameters.maxMovementFrac * this->boxSize_[0];
+    this->screen_output_every = parameters.screenOutputEvery;
+
+    // for binning
+    this->p_num_bins_lengths = parameters.numBinsLength;
+    this->p_num_bins_cosines = parameters.numBinsCosine;
+    this->histogramBinary_ = parameters.histogramBinary;
+  }
+
+  std::vector<Point> const &Vertices() const
+  {
+    return this->vertices_;
+  }
+
+  std::vector<Edge> const &Edges() const
+  {
+    return this->edges_;
+  }
+
+  std::vector<unsigned int> const &VertexOrders() const
+  {
+    return this->vertexEdgeCount_;
+  }
+
+  std::vector<StageStatistics> const &Statistics() const
+  {
+    return this->statistics_;
+  }
+
+  void ClearStatistics()
+  {
+    this->statistics_.clear();
+  }
+
+  // Records a stage that ends now. The stage must have called ResetPeakRss()
+  // when it started.
+  void RecordStage(std::string const &name, double wallSeconds, double cpuSeconds,
+                   std::map<std::string, double> const &counters = {})
+  {
+    StageStatistics stage;
+    stage.name = name;
+    stage.wallSeconds = wallSeconds;
+    stage.cpuSeconds = cpuSeconds;
+    stage.peakRssBytes = PeakRssBytes();
+    stage.counters = counters;
+    this->statistics_.push_back(stage);
+  }
+
+  // Writes the statistics of all stages to "<output-prefix>_report.json". The
+  // process peak resident set size covers the lifetime of the process and is
+  // shared by all realisations and variants computed in it.
+  void WriteReport() const
+  {
+    boost::property_tree::ptree report;
+    report.put("seed", this->seed_);
+    report.put("particles", this->voronoiParticleCount_);
+    report.put("vertices", this->vertices_.size());
+    report.put("edges", this->edges_.size());
+    report.put("process-peak-rss-bytes", ProcessPeakRssBytes());
+
+    boost::property_tree::ptree stages;
+    double wallSeconds = 0.0;
+    double cpuSeconds = 0.0;
+    for (auto const &stage : this->statistics_)
+    {
+      boost::property_tree::ptree entry;
+      entry.put("name", stage.name);
+      entry.put("wall-seconds", stage.wallSeconds);
+      entry.put("cpu-seconds", stage.cpuSeconds);
+      entry.put("cpu-seconds-estimated", stage.cpuSecondsEstimated);
+      entry.put("peak-rss-bytes", stage.peakRssBytes);
+      for (auto const &counter : stage.counters)
+        entry.put("counters." + counter.first, counter.second);
+      stages.push_back(std::make_pair("", entry));
+      wallSeconds += stage.wallSeconds;
+      cpuSeconds += stage.cpuSeconds;
+    }
+    report.add_child("stages", stages);
+    report.put("total.wall-seconds", wallSeconds);
+    report.put("total.cpu-seconds", cpuSeconds);
+
+    boost::property_tree::write_json(this->outputPrefix_.string() + "_report.json", report);
   }
 
   void run()
   {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    gen.seed(this->seed_);
-    // random number between 0 and 1
-    std::uniform_real_distribution<> dis_uni(0, 1);
+    if (this->seeds_.empty())
+      this->RunRealisation();
+    else
+      this->RunBatch();
+  }
+
+  // Computes one independent realisation per seed. Every realisation works on its
+  // own copy of the configured state and writes to "<output-prefix>_seed-<seed>".
+  void RunBatch()
+  {
+    ThreadPool pool(std::min<std::size_t>(this->parallelJobs_, this->seeds_.size()));
+    for (auto seed : this->seeds_)
+    {
+      auto realisation = std::make_shared<Voronoi>(*this);
+      realisation->seeds_.clear();
+      // the realisations already saturate the pool, so sweeps within them run sequentially
+      realisation->parallelJobs_ = 1;
+      realisation->seed_ = seed;
+      realisation->outputPrefix_ = this->outputPrefix_.string() + "_seed-" + boost::lexical_cast<std::string>(seed);
+      pool.Submit([realisation]() { realisation->RunRealisation(); });
+    }
+    pool.Wait();
+  }
+
+  void RunRealisation()
+  {
     if (this->generate_)
-      this->ComputeVoronoi(gen, dis_uni);
+      this->Generate();
     else
       this->ReadGeometry();
 
-    gen.seed(this->seed_);
+    if (this->simulate_ && !this->sweepVariants_.empty())
+    {
+      // the base network is written before the variants anneal their copies
+      this->OutputGeometry();
+      this->WriteReport();
+      this->RunSweep();
+      return;
+    }
+
     if (this->simulate_)
-      this->SimulatedAnnealing(this->mode_, gen, dis_uni);
+      this->Anneal();
 
     this->OutputGeometry();
+    this->WriteReport();
+  }
+
+  // Stream of random numbers of one stage, derived from the configured seed.
+  RandomEngine Stream(RandomStream stream, std::uint32_t substream = 0) const
+  {
+    return RandomEngine(static_cast<std::uint64_t>(static_cast<std::int64_t>(this->seed_)), stream, substream);
   }
 
-  void ComputeVoronoi(std::mt19937 &gen, std::uniform_real_distribution<> &dis_uni)
+  void Generate()
+  {
+    RandomEngine gen = this->Stream(randomStreamGeneration);
+    // random number between 0 and 1
+    std::uniform_real_distribution<> dis_uni(0, 1);
+    this->ComputeVoronoi(gen, dis_uni);
+  }
+
+  void Anneal(std::uint32_t substream = 0)
+  {
+    RandomEngine gen = this->Stream(randomStreamAnnealing, substream);
+    // random number between 0 and 1
+    std::uniform_real_distribution<> dis_uni(0, 1);
+    this->SimulatedAnnealing(this->mode_, gen, dis_uni);
+  }
+
+  // Anneals the current network once per sweep variant. The network is left
+  // untouched and shared by all variants; each variant copies it only when its
+  // annealing starts, since annealing modifies it, so at most one copy per pool
+  // thread exists at a time. Variant i draws from annealing substream i and
+  // writes to "<output-prefix>_variant-<index>".
+  void RunSweep()
+  {
+    Voronoi const *initial = this;
+    ThreadPool pool(std::min<std::size_t>(this->parallelJobs_, this->sweepVariants_.size()));
+    for (unsigned int i_variant = 0; i_variant < this->sweepVariants_.size(); ++i_variant)
+    {
+      pool.Submit([initial, i_variant]() {
+        Voronoi variant(*initial);
+        variant.sweepVariants_.clear();
+        // the variants already saturate the pool, so their output runs sequentially
+        variant.parallelJobs_ = 1;
+        // the report of a variant only covers its own stages
+        variant.statistics_.clear();
+        variant.ConfigureAnnealing(initial->sweepVariants_[i_variant]);
+        variant.outputPrefix_ = initial->outputPrefix_.string() + "_variant-" + std::to_string(i_variant);
+        variant.Anneal(i_variant);
+        variant.OutputGeometry();
+        variant.WriteReport();
+      });
+    }
+    pool.Wait();
+  }
+
+  void ComputeVoronoi(RandomEngine &gen, std::uniform_real_distribution<> &dis_uni)
   {
     std::cout << "\n\nNetwork Generation started." << std::endl;
     std::cout << "------------------------------------------------------\n"
@@ -176,6 +485,8 @@ public:
     std::cout << "1) Computing Voronoi.\n"
               << std::flush;
     auto start_voro = std::chrono::high_resolution_clock::now();
+    double start_voro_cpu = ThreadCpuSeconds();
+    ResetPeakRss();
 
     // reset variables in case of unsuccessful computation
     this->particlePositions_.clear();
@@ -221,58 +532,67 @@ public:
 
     this->particlePositions_.reserve(particleCount);
 
+    // draw all positions first, so that the container sizes its storage once in put_all
+    std::vector<int> particleIds(particleCount);
+    std::vector<double> xs(particleCount), ys(particleCount), zs(particleCount);
     for (unsigned int i = 0; i < particleCount; ++i)
     {
       x = x_min + dis_uni(gen) * (x_max - x_min);
       y = y_min + dis_uni(gen) * (y_max - y_min);
       z = z_min + dis_uni(gen) * (z_max - z_min);
-      con.put(i, x, y, z);
-      this->particlePositions_.emplace_back(std::vector<double>{x, y, z});
+      particleIds[i] = i;
+      xs[i] = x;
+      ys[i] = y;
+      zs[i] = z;
+      this->particlePositions_.push_back(Point{{x, y, z}});
     }
+    // at most parallel-jobs OpenMP threads, i.e. one per realisation in batch mode
+    con.put_all(particleIds.data(), xs.data(), ys.data(), zs.data(), particleCount, this->parallelJobs_);
 
     voro::c_loop_all loop = voro::c_loop_all(con);
 
     // cell index = particle index
     unsigned int cellIndex = 0;
     unsigned int cellCount = particleCount;
-    std::vector<double> vertices = std::vector<double>();
 
     int debug_lastUnique = -1;
     unsigned int count = 1;
+    // time spent in voro++, the remainder of the loop is deduplication
+    std::chrono::duration<double> elapsed_tessellation(0.0);
+    // linear searches for an existing vertex or edge during deduplication
+    unsigned long vertex_lookups = 0;
+    unsigned long edge_lookups = 0;
+    // one cell for all particles, compute_cell reinitialises it and keeps its grown buffers;
+    // the network only needs vertices and edges, so the cell skips neighbour tracking in its plane cuts
+    voro::voronoicell cell;
+    // flat vertex and edge buffers, refilled for every cell without reallocating
+    voro::cell_extract extract;
+    std::vector<double> cellRads = std::vector<double>();
     if (loop.start())
       do
       {
-        voro::voronoicell_neighbor cell;
-        if (con.compute_cell(cell, loop))
+        auto start_tessellation = std::chrono::high_resolution_clock::now();
+        bool cell_computed = con.compute_cell(cell, loop);
+        elapsed_tessellation += std::chrono::high_resolution_clock::now() - start_tessellation;
+        if (cell_computed)
         {
           // unused
           int cellId;
           double x, y, z, radius;
           loop.pos(cellId, x, y, z, radius);
 
-          cell.vertices(x, y, z, vertices);
+          cell.extract(x, y, z, extract);
+          const double *cellVertices = extract.pts.data();
+          const int *vertexPartners = extract.adj.data();
 
-          std::vector<std::vector<double>> cellVertices = std::vector<std::vector<double>>(vertices.size() / 3);
-
-          for (unsigned int vertexIndex = 0; vertexIndex < vertices.size(); vertexIndex += 3)
-          {
-            cellVertices[vertexIndex / 3] = std::vector<double>{vertices[vertexIndex],
-                                                                vertices[vertexIndex + 1],
-                                                                vertices[vertexIndex + 2]};
-          }
-
-          unsigned int vertexCount = cellVertices.size();
+          unsigned int vertexCount = extract.n;
 
           // statistical data for network characterization
-          std::vector<double> cellRads = std::vector<double>();
+          cellRads.clear();
           double maxRad = 0;
           double minRad = 0;
           double avgRad = 0;
 
-          std::vector<int> vertexEdgeCount;
-          cell.vertex_orders(vertexEdgeCount);
-
-          std::vector<std::vector<int>> vertexPartners = std::vector<std::vector<int>>(vertexCount);
           // std::vector<std::vector<uint32_t>> cellEdges = std::vector<std::vector<uint32_t>>();
 
           unsigned int partner1Index;
@@ -280,20 +600,18 @@ public:
 
           for (int vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
           {
-            // edges
-            vertexPartners[vertexIndex] = std::vector<int>(vertexEdgeCount[vertexIndex]);
-
-            for (int partnerIndex = 0; partnerIndex < vertexEdgeCount[vertexIndex]; ++partnerIndex)
-              vertexPartners[vertexIndex][partnerIndex] = cell.ed[vertexIndex][partnerIndex];
+            Point vertexPositionCurrent = Point{{cellVertices[3 * vertexIndex],
+                                                 cellVertices[3 * vertexIndex + 1],
+                                                 cellVertices[3 * vertexIndex + 2]}};
 
             // statistical
             double radius =
-                std::sqrt((cellVertices[vertexIndex][0] - this->particlePositions_[cellIndex][0]) *
-                              (cellVertices[vertexIndex][0] - this->particlePositions_[cellIndex][0]) +
-                          (cellVertices[vertexIndex][1] - this->particlePositions_[cellIndex][1]) *
-                              (cellVertices[vertexIndex][1] - this->particlePositions_[cellIndex][1]) +
-                          (cellVertices[vertexIndex][2] - this->particlePositions_[cellIndex][2]) *
-                              (cellVertices[vertexIndex][2] - this->particlePositions_[cellIndex][2]));
+                std::sqrt((vertexPositionCurrent[0] - this->particlePositions_[cellIndex][0]) *
+                              (vertexPositionCurrent[0] - this->particlePositions_[cellIndex][0]) +
+                          (vertexPositionCurrent[1] - this->particlePositions_[cellIndex][1]) *
+                              (vertexPositionCurrent[1] - this->particlePositions_[cellIndex][1]) +
+                          (vertexPositionCurrent[2] - this->particlePositions_[cellIndex][2]) *
+                              (vertexPositionCurrent[2] - this->particlePositions_[cellIndex][2]));
             cellRads.push_back(radius);
             avgRad += radius;
             if (radius > maxRad)
@@ -302,9 +620,9 @@ public:
               minRad = radius;
 
             // actual network creation from output of voro++
-            std::vector<double> vertexPositionCurrent = cellVertices[vertexIndex];
             bool vertexIsUnique = true;
 
+            ++vertex_lookups;
             for (int vertexIndex = 0; vertexIndex < this->vertices_.size(); ++vertexIndex)
             {
               if (std::abs(this->vertices_[vertexIndex][0] - vertexPositionCurrent[0]) < compareTolerance &&
@@ -340,12 +658,15 @@ public:
                 this->VertexIsOnHighPlane(partner1Index, 2) || this->VertexIsOnLowPlane(partner1Index, 2)};
 
             unsigned int edgesCreated = 0;
-            for (int partnerIndex = 0; partnerIndex < vertexEdgeCount[vertexIndex]; ++partnerIndex)
+            for (int partnerIndex = extract.off[vertexIndex]; partnerIndex < extract.off[vertexIndex + 1]; ++partnerIndex)
             {
-              int vertexPartnerIndexCurrent = vertexPartners[vertexIndex][partnerIndex];
-              std::vector<double> vertexPartnerPositionCurrent = cellVertices[vertexPartnerIndexCurrent];
+              int vertexPartnerIndexCurrent = vertexPartners[partnerIndex];
+              Point vertexPartnerPositionCurrent = Point{{cellVertices[3 * vertexPartnerIndexCurrent],
+                                                          cellVertices[3 * vertexPartnerIndexCurrent + 1],
+                                                          cellVertices[3 * vertexPartnerIndexCurrent + 2]}};
 
               bool vertexPartnerIsUnique = true;
+              ++vertex_lookups;
               for (int vertexIndex = 0; vertexIndex < this->vertices_.size(); ++vertexIndex)
               {
                 if (std::abs(this->vertices_[vertexIndex][0] - vertexPartnerPositionCurrent[0]) < compareTolerance &&
@@ -383,6 +704,7 @@ public:
               }
 
               bool edgeIsUnique = true;
+              ++edge_lookups;
               for (int edgeIndex = 0; edgeIndex < this->edges_.size(); ++edgeIndex)
                 if ((this->edges_[edgeIndex][0] == partner1Index &&
                      this->edges_[edgeIndex][1] == partner2Index) ||
@@ -421,8 +743,7 @@ public:
                 }
                 else
                 {
-                  this->edges_.push_back(std::vector<unsigned int>{partner1Index,
-                                                                   partner2Index});
+                  this->edges_.push_back(Edge{{partner1Index, partner2Index}});
                   ++edgesCreated;
                 }
               }
@@ -513,37 +834,49 @@ public:
     auto stop_voro = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_voro = stop_voro - start_voro;
     std::cout << "\n   Computation of Voronoi is done now. It took " << elapsed_voro.count() / 60 << " minutes. \n";
+    double elapsed_voro_cpu = ThreadCpuSeconds() - start_voro_cpu;
+    // the loop runs on this thread alone, so its CPU time is split between
+    // tessellation and deduplication in proportion to their wall time; both
+    // stages share the peak memory of the loop
+    double elapsed_tessellation_cpu =
+        elapsed_voro.count() > 0.0 ? elapsed_voro_cpu * elapsed_tessellation.count() / elapsed_voro.count() : 0.0;
+    this->RecordStage("tessellation", elapsed_tessellation.count(), elapsed_tessellation_cpu, {{"cells", cellIndex}});
+    this->statistics_.back().cpuSecondsEstimated = true;
+    this->RecordStage("deduplication", (elapsed_voro - elapsed_tessellation).count(), elapsed_voro_cpu - elapsed_tessellation_cpu,
+                      {{"vertices", this->vertices_.size()},
+                       {"edges", this->edges_.size()},
+                       {"vertex-lookups", vertex_lookups},
+                       {"edge-lookups", edge_lookups}});
+    this->statistics_.back().cpuSecondsEstimated = true;
 
     // remove double edges in periodic BC dimension
     std::cout << "\n2) Removing double edges. Current edge count: " << this->edges_.size() << "\n";
     auto start_removing_doubles = std::chrono::high_resolution_clock::now();
-    // now clean up
-    node_to_edges_ = std::vector<std::vector<unsigned int>>(vertices_.size(), std::vector<unsigned int>());
-    for (unsigned int i_edge = 0; i_edge < edges_.size(); ++i_edge)
-    {
-      node_to_edges_[this->edges_[i_edge][0]].push_back(i_edge);
-      node_to_edges_[this->edges_[i_edge][1]].push_back(i_edge);
-    }
+    double start_removing_doubles_cpu = ThreadCpuSeconds();
+    ResetPeakRss();
+    std::size_t edges_before_removing_doubles = this->edges_.size();
+    // all connectivity edits work on this graph, the final edge lists are
+    // extracted once generation is finished
+    DynamicGraph graph(vertices_.size(), this->edges_);
+    this->edges_.clear();
 
     //! Careful: creates dead nodes! (vertices still exist!)
     // if (this->applyPeriodicBCsPerDim_[0] or this->applyPeriodicBCsPerDim_[1] or this->applyPeriodicBCsPerDim_[2])
-    this->RemoveDoubles();
+    this->RemoveDoubles(graph);
 
     auto stop_removing_doubles = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_removing_doubles = stop_removing_doubles - start_removing_doubles;
     std::cout << "   Double edges are removed now. It took " << elapsed_removing_doubles.count() / 60 << " minutes. \n";
+    this->RecordStage("remove-doubles", elapsed_removing_doubles.count(), ThreadCpuSeconds() - start_removing_doubles_cpu,
+                      {{"edges-before", edges_before_removing_doubles}, {"edges", graph.EdgeCount()}});
 
     std::cout << "\n3) Cleaning up ... " << std::endl;
     ;
     auto start_cleaning = std::chrono::high_resolution_clock::now();
-
-    // now clean up
-    node_to_edges_ = std::vector<std::vector<unsigned int>>(vertices_.size(), std::vector<unsigned int>());
-    for (unsigned int i_edge = 0; i_edge < edges_.size(); ++i_edge)
-    {
-      node_to_edges_[this->edges_[i_edge][0]].push_back(i_edge);
-      node_to_edges_[this->edges_[i_edge][1]].push_back(i_edge);
-    }
+    double start_cleaning_cpu = ThreadCpuSeconds();
+    ResetPeakRss();
+    std::size_t vertices_before_cleaning = this->vertices_.size();
+    std::size_t edges_before_cleaning = graph.EdgeCount();
 
     vertices_map_.clear();
     this->vtxs_shifted_ = this->vertices_;
@@ -551,15 +884,15 @@ public:
 
     std::vector<unsigned int> vertices_with_order_1;
     std::vector<unsigned int> vertices_with_order_3;
-    for (unsigned int i_node = 0; i_node < node_to_edges_.size(); ++i_node)
+    for (unsigned int i_node = 0; i_node < graph.NodeCount(); ++i_node)
     {
       // if (node_to_edges_[i_node].size() == 4)
       //   vertices_map_[i_node] = vtxs_shifted_[i_node];
 
-      if (node_to_edges_[i_node].size() == 1)
+      if (graph.Degree(i_node) == 1)
         vertices_with_order_1.push_back(i_node);
 
-      if (node_to_edges_[i_node].size() == 3)
+      if (graph.Degree(i_node) == 3)
         vertices_with_order_3.push_back(i_node);
     }
 
@@ -568,69 +901,46 @@ public:
     {
       for (unsigned int j = 0; j < vertices_with_order_1.size(); ++j)
       {
-        if (VerticesMatch(vtxs_shifted_[vertices_with_order_3[i]],
+        // (the order 1 vertex loses its edge when it is moved)
+        if (graph.Degree(vertices_with_order_1[j]) == 1 &&
+            VerticesMatch(vtxs_shifted_[vertices_with_order_3[i]],
                           vtxs_shifted_[vertices_with_order_1[j]]))
         {
-          if (edges_[node_to_edges_[vertices_with_order_1[j]][0]][0] == vertices_with_order_1[j])
-            edges_[node_to_edges_[vertices_with_order_1[j]][0]][0] = vertices_with_order_3[i];
-          else
-            edges_[node_to_edges_[vertices_with_order_1[j]][0]][1] = vertices_with_order_3[i];
+          unsigned int edge = graph.NodeEdges(vertices_with_order_1[j])[0];
+          graph.MoveEdgeEnd(edge, graph.EdgeNodes(edge)[0] == vertices_with_order_1[j] ? 0 : 1, vertices_with_order_3[i]);
 
           // vertices_map_[vertices_with_order_3[i]] = vtxs_shifted_[vertices_with_order_3[i]];
         }
       }
     }
 
-    //! remove 'dead' vertices
-    std::vector<bool> removeVertices = std::vector<bool>(vertices_.size(), true);
-    auto edgeId = 0;
-    for (auto &edge : this->edges_)
-    {
-      removeVertices[edge[0]] = false;
-      removeVertices[edge[1]] = false;
-    }
-
-    auto finalSize = std::count_if(removeVertices.begin(), removeVertices.end(), [](bool remove) { return !remove; });
-    std::vector<uint> newVertexIds = std::vector<uint>(vertices_.size());
-    auto newVertices = std::vector<std::vector<double>>(finalSize);
-    auto newVertexId = 0;
-    for (uint vertexId = 0; vertexId < vertices_.size(); vertexId++)
-    {
-      if (!removeVertices[vertexId])
-      {
-        newVertexIds[vertexId] = newVertexId;
-        newVertices[newVertexId] = vertices_[vertexId];
-        vertices_map_[newVertexId] = vtxs_shifted_[vertexId];
-        newVertexId++;
-      }
-    }
-    vertices_ = newVertices;
-
-    for (auto &edge : this->edges_)
-    {
-      edge[0] = newVertexIds[edge[0]];
-      edge[1] = newVertexIds[edge[1]];
-    }
-
-    node_to_edges_ = std::vector<std::vector<unsigned int>>(vertices_.size(), std::vector<unsigned int>());
-    for (unsigned int i_edge = 0; i_edge < edges_.size(); ++i_edge)
-    {
-      node_to_edges_[this->edges_[i_edge][0]].push_back(i_edge);
-      node_to_edges_[this->edges_[i_edge][1]].push_back(i_edge);
-    }
+    //! 'dead' vertices (without edges) are skipped here and removed when the
+    //! network is compacted after adapting the connectivity
+    for (unsigned int vertexId = 0; vertexId < graph.NodeCount(); ++vertexId)
+      if (graph.Degree(vertexId) > 0)
+        vertices_map_[vertexId] = vtxs_shifted_[vertexId];
 
     auto stop_cleaning = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapses_cleaning = stop_cleaning - start_cleaning;
     std::cout << "   Cleaning is done now. It took " << elapses_cleaning.count() / 60 << " minutes. \n";
+    this->RecordStage("cleanup", elapses_cleaning.count(), ThreadCpuSeconds() - start_cleaning_cpu,
+                      {{"vertices-before", vertices_before_cleaning},
+                       {"edges-before", edges_before_cleaning},
+                       {"vertices", this->vertices_map_.size()},
+                       {"edges", graph.EdgeCount()}});
 
-    std::cout << "   Number of lines: " << this->edges_.size() << "\n"
+    std::cout << "   Number of lines: " << graph.EdgeCount() << "\n"
               << std::flush;
     std::cout << "   Number of nodes: " << this->vertices_for_random_draw_.size() << "\n"
               << std::flush;
 
     bool adapt_connectivity = true;
     if (adapt_connectivity)
-      this->AdaptConnectivity(gen, dis_uni);
+    {
+      RandomEngine connectivity_gen = this->Stream(randomStreamConnectivity);
+      this->AdaptConnectivity(graph, connectivity_gen, dis_uni);
+    }
+    this->AdoptGraph(graph);
 
     // Compute Vertex order
     this->vertexEdgeCount_.clear();
@@ -685,9 +995,9 @@ public:
 
   double GetEdgeLength(unsigned int edgeUId) const
   {
-    std::vector<unsigned int> partners = this->edges_[edgeUId];
-    std::vector<double> partner1Position = this->vertices_[partners[0]];
-    std::vector<double> partner2Position = this->vertices_[partners[1]];
+    Edge partners = this->edges_[edgeUId];
+    Point partner1Position = this->vertices_[partners[0]];
+    Point partner2Position = this->vertices_[partners[1]];
 
     UnShift3D(partner1Position, partner2Position);
 
@@ -717,7 +1027,7 @@ public:
   }
 
   bool PointIsOverHighPlane(
-      std::vector<double> const &point,
+      Point const &point,
       unsigned int dimension) const
   {
     return (this->boxOrigin_[dimension] +
@@ -726,7 +1036,7 @@ public:
 
   bool PointIsOverLowPlane(
 
-      std::vector<double> const &point,
+      Point const &point,
       unsigned int dimension) const
   {
     return (this->boxOrigin_[dimension] -
@@ -734,7 +1044,7 @@ public:
   }
 
   bool PointIsOnHighPlane(
-      std::vector<double> const &point,
+      Point const &point,
       unsigned int dimension) const
   {
     double compareTolerance = 1e-13;
@@ -744,7 +1054,7 @@ public:
   }
 
   bool PointIsOnLowPlane(
-      std::vector<double> const &point,
+      Point const &point,
       unsigned int dimension) const
   {
     double compareTolerance = 1e-13;
@@ -754,8 +1064,8 @@ public:
   }
 
   bool VerticesMatch(
-      std::vector<double> const &vertex1,
-      std::vector<double> const &vertex2) const
+      Point const &vertex1,
+      Point const &vertex2) const
   {
     double compareTolerance = 1e-7;
     if (std::abs(vertex2[0] - vertex1[0]) > compareTolerance)
@@ -768,14 +1078,17 @@ public:
     return true;
   }
 
+  // Shifts vertices outside of the box back into it and returns the ids of the
+  // shifted vertices.
   std::vector<unsigned int> ShiftVertices(
 
-      std::vector<std::vector<double>> &vertices) const
+      std::vector<Point> &vertices) const
   {
-    std::vector<unsigned int> shifted_lines;
-    shifted_lines.reserve(static_cast<int>(vertices.size() * 0.2));
+    std::vector<unsigned int> shifted_vertices;
+    shifted_vertices.reserve(static_cast<int>(vertices.size() * 0.1));
     for (unsigned int i = 0; i < vertices.size(); ++i)
     {
+      bool shifted = false;
       for (auto dim : {0, 1, 2})
       {
         if (!true)
@@ -784,30 +1097,29 @@ public:
         if (this->PointIsOverHighPlane(vertices[i], dim))
         {
           this->ShiftPointDown(vertices[i], this->boxSize_, dim);
-          for (unsigned int k = 0; k < node_to_edges_[i].size(); ++k)
-            shifted_lines.push_back(node_to_edges_[i][k]);
+          shifted = true;
         }
 
         else if (this->PointIsOverLowPlane(vertices[i], dim))
         {
           this->ShiftPointUp(vertices[i], this->boxSize_, dim);
-
-          for (unsigned int k = 0; k < node_to_edges_[i].size(); ++k)
-            shifted_lines.push_back(node_to_edges_[i][k]);
+          shifted = true;
         }
       }
+      if (shifted)
+        shifted_vertices.push_back(i);
     }
-    return shifted_lines;
+    return shifted_vertices;
   }
 
-  void ShiftPointDown(std::vector<double> &point,
+  void ShiftPointDown(Point &point,
                       std::vector<double> const &boxSize,
                       unsigned int dim) const
   {
     point[dim] -= boxSize[dim];
   }
 
-  void ShiftPointUp(std::vector<double> &point,
+  void ShiftPointUp(Point &point,
                     std::vector<double> const &boxSize,
                     unsigned int dim) const
   {
@@ -839,14 +1151,14 @@ public:
   }
 
   void UnShift3D(
-      std::vector<double> &d, std::vector<double> const &ref, std::vector<double> const X = std::vector<double>(3, 0.0)) const
+      Point &d, Point const &ref, Point const X = Point{{0.0, 0.0, 0.0}}) const
   {
     for (int dim = 0; dim < 3; ++dim)
       UnShift1D(dim, d[dim], ref[dim], X[dim]);
   }
 
   void get_unshifted_dir_vec(
-      std::vector<double> x_1, std::vector<double> const &x_2, std::vector<double> &dirvec) const
+      Point x_1, Point const &x_2, Point &dirvec) const
   {
     UnShift3D(x_1, x_2);
 
@@ -855,7 +1167,7 @@ public:
   };
 
   std::vector<int> Permutation(int number,
-                               std::mt19937 &gen,
+                               RandomEngine &gen,
                                std::uniform_real_distribution<> &dis_uni) const
   {
     // auxiliary variable
@@ -880,7 +1192,7 @@ public:
     return randorder;
   }
 
-  double l2_norm(std::vector<double> const &u) const
+  double l2_norm(Point const &u) const
   {
     double accum = 0.;
     for (int i = 0; i < u.size(); ++i)
@@ -890,10 +1202,10 @@ public:
     return sqrt(accum);
   }
   double l2_norm_dist_two_points(
-      std::vector<double> x_1, std::vector<double> const &x_2) const
+      Point x_1, Point const &x_2) const
   {
     UnShift3D(x_1, x_2);
-    std::vector<double> dirvec(3, 0.0);
+    Point dirvec = Point{{0.0, 0.0, 0.0}};
 
     for (int idim = 0; idim < 3; ++idim)
       dirvec[idim] = x_1[idim] - x_2[idim];
@@ -904,8 +1216,8 @@ public:
   void ComputeCosineDistributionOfNode(
 
       const unsigned int i_node,
-      std::vector<double> &dir_vec_1,
-      std::vector<double> &dir_vec_2,
+      Point &dir_vec_1,
+      Point &dir_vec_2,
       double interval_size_cosines,
       std::vector<std::vector<double>> &node_cosine_to_bin,
       std::vector<double> &cosine_distribution)
@@ -968,7 +1280,7 @@ public:
 
       const unsigned int i_edge,
       double length_norm_fac,
-      std::vector<double> &dir_vec_1,
+      Point &dir_vec_1,
       double interval_size_lengths,
       std::vector<double> &edge_length_to_bin,
       std::vector<double> &length_distribution) const
@@ -1021,7 +1333,7 @@ public:
  *----------------------------------------------------------------------*/
   void RevertUpdateOfNodes(
       std::set<unsigned int> const &nodes_to_revert,
-      std::vector<std::vector<double>> const &nodes_backup)
+      std::vector<Point> const &nodes_backup)
   {
     for (auto const &i_node : nodes_to_revert)
     {
@@ -1033,7 +1345,7 @@ public:
  *----------------------------------------------------------------------*/
   void UpdateBackUpOfNodes(
       std::set<unsigned int> const &nodes_to_revert,
-      std::vector<std::vector<double>> &nodes_backup)
+      std::vector<Point> &nodes_backup)
   {
     for (auto const &i_node : nodes_to_revert)
     {
@@ -1045,7 +1357,7 @@ public:
  *----------------------------------------------------------------------*/
   void RevertUpdateOfEdges(
       std::set<unsigned int> const &edges_to_revert,
-      std::vector<std::vector<unsigned int>> const &uniqueVertexEdgePartners_backup)
+      std::vector<Edge> const &uniqueVertexEdgePartners_backup)
   {
     for (auto const &i_edge : edges_to_revert)
     {
@@ -1057,7 +1369,7 @@ public:
  *----------------------------------------------------------------------*/
   void UpdateBackUpOfEdges(
       std::set<unsigned int> const &edges_to_revert,
-      std::vector<std::vector<unsigned int>> &uniqueVertexEdgePartners_backup)
+      std::vector<Edge> &uniqueVertexEdgePartners_backup)
   {
     for (auto const &i_edge : edges_to_revert)
     {
@@ -1164,49 +1476,50 @@ public:
     curr_energy_cosine *= 1.0 / (num_cosines * num_cosines);
   }
 
-  void RemoveDoubles()
+  void RemoveDoubles(DynamicGraph &graph)
   {
     auto start_remove = std::chrono::high_resolution_clock::now();
-    std::vector<std::vector<double>> vtxs_shifted = this->vertices_;
+    std::vector<Point> vtxs_shifted = this->vertices_;
 
-    std::vector<unsigned int> shifted_lines = this->ShiftVertices(vtxs_shifted);
+    std::vector<unsigned int> shifted_vertices = this->ShiftVertices(vtxs_shifted);
 
-    // make unique
+    // lines at shifted vertices, made unique
     std::set<int> s;
-    unsigned size = shifted_lines.size();
-    for (unsigned int k = 0; k < size; ++k)
-      s.insert(shifted_lines[k]);
-    shifted_lines.assign(s.begin(), s.end());
+    for (auto i_node : shifted_vertices)
+      for (auto i_edge : graph.NodeEdges(i_node))
+        s.insert(i_edge);
+    std::vector<unsigned int> shifted_lines(s.begin(), s.end());
 
+    std::vector<Edge> const &edges = graph.Edges();
+    std::vector<bool> is_double(edges.size(), false);
     unsigned int count = 1;
     for (unsigned int i = 0; i < shifted_lines.size(); ++i)
     {
-      if ((edges_[shifted_lines[i]][0] == INT32_MAX) || (edges_[shifted_lines[i]][1] == INT32_MAX))
+      if (is_double[shifted_lines[i]])
       {
         continue;
       }
 
-      for (unsigned int j = 0; j < edges_.size(); ++j)
+      for (unsigned int j = 0; j < edges.size(); ++j)
       {
-        if (shifted_lines[i] == j or
-            (edges_[j][0] == INT32_MAX) or (edges_[j][1] == INT32_MAX))
+        if (shifted_lines[i] == j or is_double[j])
         {
           continue;
         }
-        if ((edges_[shifted_lines[i]][0] == INT32_MAX) || (edges_[shifted_lines[i]][1] == INT32_MAX))
+        if (is_double[shifted_lines[i]])
         {
           continue;
         }
 
-        std::vector<double> edge1vtx1 = vtxs_shifted[edges_[shifted_lines[i]][0]];
-        std::vector<double> edge1vtx2 = vtxs_shifted[edges_[shifted_lines[i]][1]];
-        std::vector<double> edge2vtx1 = vtxs_shifted[edges_[j][0]];
-        std::vector<double> edge2vtx2 = vtxs_shifted[edges_[j][1]];
+        Point const &edge1vtx1 = vtxs_shifted[edges[shifted_lines[i]][0]];
+        Point const &edge1vtx2 = vtxs_shifted[edges[shifted_lines[i]][1]];
+        Point const &edge2vtx1 = vtxs_shifted[edges[j][0]];
+        Point const &edge2vtx2 = vtxs_shifted[edges[j][1]];
 
         if ((this->VerticesMatch(edge1vtx1, edge2vtx1) && this->VerticesMatch(edge1vtx2, edge2vtx2)) ||
             (this->VerticesMatch(edge1vtx1, edge2vtx2) && this->VerticesMatch(edge1vtx2, edge2vtx1)))
         {
-          edges_[shifted_lines[i] > j ? shifted_lines[i] : j] = std::vector<unsigned int>{INT32_MAX, INT32_MAX};
+          is_double[shifted_lines[i] > j ? shifted_lines[i] : j] = true;
         }
       }
 
@@ -1253,7 +1566,7 @@ public:
     //     if ((this->VerticesMatch(edge1vtx1, edge2vtx1) && this->VerticesMatch(edge1vtx2, edge2vtx2)) ||
     //         (this->VerticesMatch(edge1vtx1, edge2vtx2) && this->VerticesMatch(edge1vtx2, edge2vtx1)))
     //     {
-    //       edge2 = std::vector<unsigned int>{INT32_MAX, INT32_MAX};
+    //       edge2 = Edge{{INT32_MAX, INT32_MAX}};
     //     }
     //     ++edge2Id;
     //   }
@@ -1271,21 +1584,50 @@ public:
     // }
     std::cout << std::endl;
 
-    this->edges_.erase(
-        std::remove(this->edges_.begin(),
-                    this->edges_.end(),
-                    std::vector<unsigned int>{INT32_MAX, INT32_MAX}),
-        this->edges_.end());
+    // remove from the back, so every edge moved into a gap is one that is kept
+    for (unsigned int i_edge = is_double.size(); i_edge-- > 0;)
+      if (is_double[i_edge])
+        graph.RemoveEdge(i_edge);
+  }
+
+  // Takes the generated network from the graph: vertices without edges are
+  // removed, the remaining ones renumbered in order, and the edges and node to
+  // edge lists are stored.
+  void AdoptGraph(DynamicGraph const &graph)
+  {
+    DynamicGraph::Compacted network = graph.Compact();
+
+    std::vector<Point> vertices;
+    vertices.reserve(network.nodeEdgeOffsets.size() - 1);
+    std::map<unsigned int, Point> vertices_map;
+    for (unsigned int vertexId = 0; vertexId < network.newNodeIds.size(); ++vertexId)
+      if (network.newNodeIds[vertexId] != DynamicGraph::removed)
+      {
+        vertices.push_back(this->vertices_[vertexId]);
+        vertices_map.emplace_hint(vertices_map.end(), network.newNodeIds[vertexId], this->vertices_map_[vertexId]);
+      }
+    this->vertices_ = std::move(vertices);
+    this->vertices_map_ = std::move(vertices_map);
+    for (auto &vertexId : this->vertices_for_random_draw_)
+      vertexId = network.newNodeIds[vertexId];
+
+    this->edges_ = std::move(network.edges);
+    this->node_to_edges_.assign(this->vertices_.size(), std::vector<unsigned int>());
+    for (unsigned int i_node = 0; i_node < this->vertices_.size(); ++i_node)
+      this->node_to_edges_[i_node].assign(network.nodeEdgeIds.begin() + network.nodeEdgeOffsets[i_node],
+                                          network.nodeEdgeIds.begin() + network.nodeEdgeOffsets[i_node + 1]);
   }
 
-  void AdaptConnectivity(std::mt19937 &gen, std::uniform_real_distribution<> &dis_uni)
+  void AdaptConnectivity(DynamicGraph &graph, RandomEngine &gen, std::uniform_real_distribution<> &dis_uni)
   {
 
     std::cout << "\n4) Adapting valency distribution " << std::endl;
     auto start_valency = std::chrono::high_resolution_clock::now();
+    double start_valency_cpu = ThreadCpuSeconds();
+    ResetPeakRss();
+    std::size_t edges_before_valency = graph.EdgeCount();
 
     unsigned int num_nodes = this->vertices_map_.size();
-    unsigned int num_lines = this->edges_.size();
 
     // put all vertex ids in vector to ease random draw of vertex
     vertices_for_random_draw_.reserve(vertices_map_.size());
@@ -1295,9 +1637,8 @@ public:
     // Adapt valency distribution to collagen network according to Nan2018
     // "Realizations of highly heterogeneous collagen networks via stochastic reconstruction
     //  for micromechanical analysis of tumor cell invasion" figure 6
-    std::uniform_int_distribution<> dis_rand_line(0, 3);
-    std::vector<double> dir_1(3, 0.0);
-    std::vector<double> dir_2(3, 0.0);
+    Point dir_1 = Point{{0.0, 0.0, 0.0}};
+    Point dir_2 = Point{{0.0, 0.0, 0.0}};
 
     unsigned int num_z_3 = std::floor(0.72 * num_nodes);
     unsigned int num_z_4 = std::floor(0.2 * num_nodes);
@@ -1306,141 +1647,104 @@ public:
 
     num_z_4 += num_nodes - (num_z_3 + num_z_4 + num_z_5 + num_z_6);
 
-    // first take care of z = 6 (starting from all being z = 4)
-    std::uniform_int_distribution<> rand_node(0, vertices_for_random_draw_.size() - 1);
+    // Nodes of order 4 are the candidates for additional lines. They are kept in
+    // a bucket for drawing the first node and in a cell list for drawing a second
+    // node within a third of the box, and both are updated as soon as a node
+    // leaves order 4. The first node is drawn from valid candidates only, the
+    // second from the cells that reach into the sphere around the first node.
+    double max_line_length = one_third * this->boxSize_[0];
+    IdBucket first_candidates(graph.NodeCount());
+    PeriodicCellList second_candidates(
+        {{this->boxOrigin_[0] - this->boxSize_[0] / 2, this->boxOrigin_[1] - this->boxSize_[1] / 2, this->boxOrigin_[2] - this->boxSize_[2] / 2}},
+        {{this->boxSize_[0], this->boxSize_[1], this->boxSize_[2]}}, max_line_length, graph.NodeCount());
+    for (auto const &iter : vertices_map_)
+      if (graph.Degree(iter.first) == 4)
+      {
+        first_candidates.Insert(iter.first);
+        second_candidates.Insert(iter.first, iter.second);
+      }
+
+    // draws a node of order 4 close enough to node_1 and connects both
+    auto add_line = [&](unsigned int node_1) {
+      Point const &position_1 = vertices_map_[node_1];
+      auto close_to_node_1 = [&](unsigned int node_2) {
+        if (node_2 == node_1)
+          return false;
+        for (unsigned int dim = 0; dim < 3; ++dim)
+          dir_1[dim] = position_1[dim] - vertices_map_[node_2][dim];
+        UnShift3D(dir_1, dir_2);
+        return l2_norm(dir_1) < max_line_length;
+      };
+      unsigned int node_2 = 0;
+      if (!second_candidates.Draw(position_1, gen, close_to_node_1, node_2))
+        return false;
+
+      // add line to these nodes
+      graph.AddEdge(node_1, node_2);
+      for (auto node : {node_1, node_2})
+      {
+        first_candidates.Erase(node);
+        second_candidates.Erase(node);
+      }
+      return true;
+    };
 
+    // first take care of z = 6 (starting from all being z = 4)
     unsigned int num_curr_z_6 = 0;
     unsigned int num_curr_z_5 = 0;
 
-    while (num_curr_z_6 < num_z_6)
+    while (num_curr_z_6 < num_z_6 and not first_candidates.Empty())
     {
-      unsigned int node_1 = vertices_for_random_draw_[rand_node(gen)];
-
-      if (node_to_edges_[node_1].size() == 4)
+      unsigned int node_1 = first_candidates[std::uniform_int_distribution<std::size_t>(0, first_candidates.Size() - 1)(gen)];
+      // no node of order 4 is close enough, node_1 cannot get more lines
+      if (!add_line(node_1))
       {
-        for (int i = 0; i < 2; ++i)
-        {
-          bool success = false;
-
-          unsigned int node_2 = 0;
-          while (not success)
-          {
-            node_2 = vertices_for_random_draw_[rand_node(gen)];
-            if (node_2 == node_1 or node_to_edges_[node_2].size() != 4)
-              continue;
-
-            // check distance
-            for (unsigned int dim = 0; dim < 3; ++dim)
-              dir_1[dim] = vertices_map_[node_1][dim] - vertices_map_[node_2][dim];
-
-            UnShift3D(dir_1, dir_2);
-
-            if (l2_norm(dir_1) < one_third * this->boxSize_[0])
-            {
-              success = true;
-              break;
-            }
-          }
-
-          // add line to these nodes
-          std::vector<unsigned int> new_line(2, 0);
-          new_line[0] = node_1;
-          new_line[1] = node_2;
-          node_to_edges_[node_1].push_back(edges_.size());
-          node_to_edges_[node_2].push_back(edges_.size());
-          edges_.push_back(new_line);
-          ++num_curr_z_5;
-        }
-        ++num_curr_z_6;
+        first_candidates.Erase(node_1);
+        continue;
       }
+      ++num_curr_z_5;
+      if (add_line(node_1))
+        ++num_curr_z_6;
+      // either the second partner or node_1 itself (if none was found) has order 5
+      ++num_curr_z_5;
     }
 
     // now take care of z = 5
-    while (num_curr_z_5 < num_z_5)
+    while (num_curr_z_5 < num_z_5 and not first_candidates.Empty())
     {
-      unsigned int node_1 = vertices_for_random_draw_[rand_node(gen)];
-
-      bool success = false;
-      if (node_to_edges_[node_1].size() == 4)
-      {
-        unsigned int node_2 = 0;
-        while (not success)
-        {
-          node_2 = vertices_for_random_draw_[rand_node(gen)];
-          if (node_2 == node_1 or node_to_edges_[node_2].size() != 4)
-            continue;
-
-          // check distance
-          for (unsigned int dim = 0; dim < 3; ++dim)
-            dir_1[dim] = vertices_map_[node_1][dim] - vertices_map_[node_2][dim];
-
-          UnShift3D(dir_1, dir_2);
-
-          if (l2_norm(dir_1) < one_third * this->boxSize_[0])
-          {
-            success = true;
-            break;
-          }
-        }
-
-        // add line to these nodes
-        std::vector<unsigned int> new_line(2, 0);
-        new_line[0] = node_1;
-        new_line[1] = node_2;
-        node_to_edges_[node_1].push_back(edges_.size());
-        node_to_edges_[node_2].push_back(edges_.size());
-        edges_.push_back(new_line);
+      unsigned int node_1 = first_candidates[std::uniform_int_distribution<std::size_t>(0, first_candidates.Size() - 1)(gen)];
+      if (add_line(node_1))
         num_curr_z_5 += 2;
-      }
+      else
+        first_candidates.Erase(node_1);
     }
 
     // now do with z = 3
     unsigned int num_found = 0;
-    unsigned int max_try = 100;
+    std::vector<unsigned int> removable_lines;
     std::vector<int> random_order = Permutation(vertices_for_random_draw_.size(), gen, dis_uni);
     // do twice for better results
     for (int s = 0; s < 2; ++s)
     {
       for (unsigned int rand_node_i = 0; rand_node_i < random_order.size(); ++rand_node_i)
       {
-        int i_node = vertices_for_random_draw_[random_order[rand_node_i]];
+        unsigned int i_node = vertices_for_random_draw_[random_order[rand_node_i]];
 
-        if (node_to_edges_[i_node].size() == 4)
+        if (graph.Degree(i_node) == 4)
         {
-          unsigned int try_i = 1;
-          bool success = false;
-          unsigned int random_line = dis_rand_line(gen);
-          unsigned int second_affected_node = -1;
-          do
+          // draw the line to remove from those whose other node also has order 4
+          removable_lines.clear();
+          for (auto line_id : graph.NodeEdges(i_node))
           {
-            if (edges_[node_to_edges_[i_node][random_line]][0] == i_node)
-              second_affected_node = edges_[node_to_edges_[i_node][random_line]][1];
-            else
-              second_affected_node = edges_[node_to_edges_[i_node][random_line]][0];
-
-            if (node_to_edges_[second_affected_node].size() == 4)
-            {
-              success = true;
-              break;
-            }
-
-            ++try_i;
-
-          } while (try_i < max_try);
-
-          if (not success)
+            Edge const &line = graph.EdgeNodes(line_id);
+            unsigned int second_affected_node = line[0] == i_node ? line[1] : line[0];
+            if (graph.Degree(second_affected_node) == 4)
+              removable_lines.push_back(line_id);
+          }
+          if (removable_lines.empty())
             continue;
 
-          //! don't erase yet! this destroys the order in edgeIds_valid!
-          this->edges_[node_to_edges_[i_node][random_line]] =
-              std::vector<unsigned int>{INT32_MAX, INT32_MAX};
-
-          int index = std::distance(node_to_edges_[second_affected_node].begin(), std::find(node_to_edges_[second_affected_node].begin(),
-                                                                                            node_to_edges_[second_affected_node].end(),
-                                                                                            node_to_edges_[i_node][random_line]));
-
-          node_to_edges_[second_affected_node].erase(node_to_edges_[second_affected_node].begin() + index);
-          node_to_edges_[i_node].erase(node_to_edges_[i_node].begin() + random_line);
+          graph.RemoveEdge(removable_lines[std::uniform_int_distribution<std::size_t>(0, removable_lines.size() - 1)(gen)]);
 
           num_found += 2;
         }
@@ -1449,29 +1753,15 @@ public:
           break;
       }
     }
-    // now really remove edges
-    // erase now
-    this->edges_.erase(std::remove(this->edges_.begin(),
-                                   this->edges_.end(),
-                                   std::vector<unsigned int>{INT32_MAX, INT32_MAX}),
-                       this->edges_.end());
-    num_lines = edges_.size();
-
-    // recompute node to edges after adaption of connectivity
-    node_to_edges_.clear();
-    node_to_edges_ = std::vector<std::vector<unsigned int>>(vertices_.size(), std::vector<unsigned int>());
-    for (unsigned int i_edge = 0; i_edge < edges_.size(); ++i_edge)
-    {
-      node_to_edges_[this->edges_[i_edge][0]].push_back(i_edge);
-      node_to_edges_[this->edges_[i_edge][1]].push_back(i_edge);
-    }
 
     auto stop_valency = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_valency = stop_valency - start_valency;
     std::cout << "   Adaption of valency distribution is done now. It took " << elapsed_valency.count() / 60 << " minutes. \n";
+    this->RecordStage("adapt-connectivity", elapsed_valency.count(), ThreadCpuSeconds() - start_valency_cpu,
+                      {{"edges-before", edges_before_valency}, {"edges", graph.EdgeCount()}});
   }
 
-  void SimulatedAnnealing(uint mode, std::mt19937 &gen, std::uniform_real_distribution<> &dis_uni)
+  void SimulatedAnnealing(uint mode, RandomEngine &gen, std::uniform_real_distribution<> &dis_uni)
   {
 
     // put all vertex ids in vector to ease random draw of vertex
@@ -1489,6 +1779,8 @@ public:
     std::cout << "\n5) Starting Simulated Annealing\n\n\n";
     // time measurement start
     auto start = std::chrono::high_resolution_clock::now();
+    double start_cpu = ThreadCpuSeconds();
+    ResetPeakRss();
 
     unsigned int num_nodes = vertices_map_.size();
     unsigned int num_lines = edges_.size();
@@ -1504,9 +1796,8 @@ public:
     std::uniform_real_distribution<> dis_node_move(-1, 1);
 
     // ... and even more
-    std::vector<double> rand_new_node_pos(3, 0.0);
-    std::vector<std::vector<double>> uniqueVertices_backup(this->vertices_);
-    std::vector<std::vector<unsigned int>> uniqueVertexEdgePartners_backup(this->edges_);
+    std::vector<Point> uniqueVertices_backup(this->vertices_);
+    std::vector<Edge> uniqueVertexEdgePartners_backup(this->edges_);
     unsigned int random_line_1 = 0;
     unsigned int random_line_2 = 0;
     unsigned int iter = 0;
@@ -1516,6 +1807,11 @@ public:
     double last_energy_cosine = 0.0;
     double temperature = temperature_inital;
     double delta_energy = 0.0;
+    // proposal and acceptance counts per move type for the stage statistics
+    unsigned long proposals_move_1 = 0;
+    unsigned long accepted_move_1 = 0;
+    unsigned long proposals_move_2 = 0;
+    unsigned long accepted_move_2 = 0;
     // normalize lengths according to Lindström
     double length_norm_fac = 1.0 / std::pow((num_nodes / (this->boxSize_[0] * this->boxSize_[1] * this->boxSize_[2])), -1.0 / 3.0);
 
@@ -1525,7 +1821,8 @@ public:
     double interval_size_lengths = 5.0 / p_num_bins_lengths;
     double interval_size_cosines = 2.0 / p_num_bins_cosines;
 
-    // build edge_map_
+    // build edge_map_ (from scratch, the network may have been annealed before)
+    this->edge_map_.clear();
     for (unsigned int i_edge = 0; i_edge < edges_.size(); ++i_edge)
     {
       edge_map_[this->edges_[i_edge][0]].push_back(i_edge);
@@ -1535,8 +1832,8 @@ public:
     // compute cosine distribution
     std::vector<double> cosine_distribution(p_num_bins_cosines, 0.0);
     std::vector<std::vector<double>> node_cosine_to_bin(vertices_.size(), std::vector<double>());
-    std::vector<double> dir_vec_1(3, 0.0);
-    std::vector<double> dir_vec_2(3, 0.0);
+    Point dir_vec_1 = Point{{0.0, 0.0, 0.0}};
+    Point dir_vec_2 = Point{{0.0, 0.0, 0.0}};
     for (auto const &i_node : edge_map_)
     {
       ComputeCosineDistributionOfNode(i_node.first, dir_vec_1, dir_vec_2,
@@ -1564,21 +1861,26 @@ public:
 
     // write initial distributions
     // output initial filament lengths
-    std::ofstream filLen_file_initial(this->outputPrefix_.string() + "_fil_lengths_initial.txt");
-    filLen_file_initial << "fil_lengths\n";
-    for (unsigned int filId = 0; filId < this->edges_.size(); ++filId)
-      filLen_file_initial << this->GetFilamentLength(filId) * length_norm_fac << "\n";
-
-    // print final cosine distribution
-    std::ofstream filcoshisto_initial_file(this->outputPrefix_.string() + "_cosine_histo_initial.txt");
-    filcoshisto_initial_file << "cosine\n";
-    for (unsigned int i_c = 0; i_c < cosine_distribution.size(); ++i_c)
-      for (unsigned int j_c = 0; j_c < cosine_distribution[i_c]; ++j_c)
-        filcoshisto_initial_file << interval_size_cosines * i_c + interval_size_cosines * 0.5 - 1.0 << "\n";
-
-    // write temperature and energies to file
-    std::ofstream fil_obj_function(this->outputPrefix_.string() + "_obj_function.txt");
-    fil_obj_function << "step, temperature, length, cosine, total \n";
+    // all diagnostic files are written in the background
+    DiagnosticsWriter diagnostics;
+    std::size_t fil_obj_function = 0;
+    if (this->writeDiagnostics_)
+    {
+      std::ostringstream filLen_initial;
+      filLen_initial << "fil_lengths\n";
+      for (unsigned int filId = 0; filId < this->edges_.size(); ++filId)
+        filLen_initial << this->GetFilamentLength(filId) * length_norm_fac << "\n";
+      std::size_t filLen_file_initial = diagnostics.Open(this->outputPrefix_.string() + "_fil_lengths_initial.txt");
+      diagnostics.Write(filLen_file_initial, filLen_initial.str());
+      diagnostics.Close(filLen_file_initial);
+
+      // print initial cosine distribution
+      this->WriteCosineHistogram(diagnostics, "_cosine_histo_initial", interval_size_cosines, cosine_distribution);
+
+      // write temperature and energies to file
+      fil_obj_function = diagnostics.Open(this->outputPrefix_.string() + "_obj_function.txt");
+      diagnostics.Write(fil_obj_function, "step, temperature, length, cosine, total \n");
+    }
 
     //---------------------------
     // START SIMULATED ANNEALING
@@ -1597,6 +1899,7 @@ public:
         do
         {
           ++subiter;
+          ++proposals_move_1;
           success = true;
           // select a random node
           unsigned int rand_node_id = vertices_for_random_draw_[dis_node(gen)];
@@ -1657,6 +1960,7 @@ public:
             UpdateBackUpOfNodes(affected_nodes, uniqueVertices_backup);
             UpdateBackupOfCosineDistribution(affected_nodes, node_cosine_to_bin, node_cosine_to_bin_backup);
             UpdateBackupOfLineDistribution(affected_lines, edge_length_to_bin, edge_length_to_bin_backup);
+            ++accepted_move_1;
             success = true;
           }
           else
@@ -1674,11 +1978,16 @@ public:
           std::cout << "cosine energy move 1 " << curr_energy_cosine << std::endl;
           std::cout << " iter " << iter << std::endl;
 
-          fil_obj_function << iter;
-          fil_obj_function << ", " << temperature;
-          fil_obj_function << ", " << curr_energy_line;
-          fil_obj_function << ", " << curr_energy_cosine;
-          fil_obj_function << ", " << curr_energy_line + curr_energy_cosine << "\n";
+          if (this->writeDiagnostics_)
+          {
+            std::ostringstream obj_function;
+            obj_function << iter;
+            obj_function << ", " << temperature;
+            obj_function << ", " << curr_energy_line;
+            obj_function << ", " << curr_energy_cosine;
+            obj_function << ", " << curr_energy_line + curr_energy_cosine << "\n";
+            diagnostics.Write(fil_obj_function, obj_function.str());
+          }
         }
       }
 
@@ -1704,6 +2013,7 @@ public:
         do
         {
           ++subiter;
+          ++proposals_move_2;
           success = true;
 
           // select two (different) random lines
@@ -1846,6 +2156,7 @@ public:
             UpdateBackUpOfEdges(affected_lines, uniqueVertexEdgePartners_backup);
             UpdateBackupOfCosineDistribution(affected_nodes, node_cosine_to_bin, node_cosine_to_bin_backup);
             UpdateBackupOfLineDistribution(affected_lines, edge_length_to_bin, edge_length_to_bin_backup);
+            ++accepted_move_2;
             success = true;
           }
           else
@@ -1883,121 +2194,346 @@ public:
     } while ((iter < max_iter) and ((last_energy_line > tolerance) or (last_energy_cosine > tolerance)));
 
     // print final cosine distribution
-    std::ofstream filcoshisto_file(this->outputPrefix_.string() + "_cosine_histo.txt");
-    filcoshisto_file << "cosine\n";
-    for (unsigned int i_c = 0; i_c < cosine_distribution.size(); ++i_c)
-      for (unsigned int j_c = 0; j_c < cosine_distribution[i_c]; ++j_c)
-        filcoshisto_file << interval_size_cosines * i_c + interval_size_cosines * 0.5 - 1.0 << "\n";
-
-    std::ofstream filcos_file(this->outputPrefix_.string() + "_cosine_normal.txt");
-    filcos_file << "bin, cosine \n";
-    for (unsigned int i_c = 0; i_c < cosine_distribution.size(); ++i_c)
+    if (this->writeDiagnostics_)
     {
-      filcos_file << interval_size_cosines * i_c + interval_size_cosines * 0.5;
-      filcos_file << ", " << cosine_distribution[i_c] - 1.0 << "\n";
+      diagnostics.Close(fil_obj_function);
+      this->WriteCosineHistogram(diagnostics, "_cosine_histo", interval_size_cosines, cosine_distribution);
+
+      std::ostringstream filcos;
+      filcos << "bin, cosine \n";
+      for (unsigned int i_c = 0; i_c < cosine_distribution.size(); ++i_c)
+      {
+        filcos << interval_size_cosines * i_c + interval_size_cosines * 0.5;
+        filcos << ", " << cosine_distribution[i_c] - 1.0 << "\n";
+      }
+      std::size_t filcos_file = diagnostics.Open(this->outputPrefix_.string() + "_cosine_normal.txt");
+      diagnostics.Write(filcos_file, filcos.str());
+      diagnostics.Close(filcos_file);
     }
 
+    // the stage ends once the queued diagnostics are written
+    double writer_cpu = diagnostics.CpuSeconds();
+
     // time measurement end
     auto stop = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = stop - start;
 
     std::cout << "\nSimulation annealing took " << elapsed.count() / 60 << " minutes for " << iter << " iterations" << std::endl;
+    this->RecordStage("annealing", elapsed.count(), ThreadCpuSeconds() - start_cpu + writer_cpu,
+                      {{"mode", mode},
+                       {"iterations", iter},
+                       {"temperature", temperature},
+                       {"energy-line", last_energy_line},
+                       {"energy-cosine", last_energy_cosine},
+                       {"proposals-move-1", proposals_move_1},
+                       {"accepted-move-1", accepted_move_1},
+                       {"proposals-move-2", proposals_move_2},
+                       {"accepted-move-2", accepted_move_2}});
     std::cout << "Final line energy:   " << last_energy_line << std::endl;
     std::cout << "Final cosine energy: " << last_energy_cosine << std::endl;
   }
 
+  // Writes one (bin centre, count) pair per bin of the cosine distribution, either
+  // as text to "<output-prefix><name>.txt" or as pairs of doubles to "<output-prefix><name>.bin".
+  void WriteCosineHistogram(DiagnosticsWriter &diagnostics,
+                            std::string const &name,
+                            double interval_size_cosines,
+                            std::vector<double> const &cosine_distribution) const
+  {
+    std::string histogram;
+    if (this->histogramBinary_)
+    {
+      histogram.resize(2 * cosine_distribution.size() * sizeof(double));
+      char *position = &histogram[0];
+      for (unsigned int i_c = 0; i_c < cosine_distribution.size(); ++i_c)
+      {
+        double bin[2] = {interval_size_cosines * i_c + interval_size_cosines * 0.5 - 1.0, cosine_distribution[i_c]};
+        std::memcpy(position, bin, sizeof(bin));
+        position += sizeof(bin);
+      }
+    }
+    else
+    {
+      std::ostringstream histogram_text;
+      histogram_text << "cosine, count\n";
+      for (unsigned int i_c = 0; i_c < cosine_distribution.size(); ++i_c)
+        histogram_text << interval_size_cosines * i_c + interval_size_cosines * 0.5 - 1.0 << ", "
+                       << cosine_distribution[i_c] << "\n";
+      histogram = histogram_text.str();
+    }
+
+    std::size_t file = diagnostics.Open(this->outputPrefix_.string() + name + (this->histogramBinary_ ? ".bin" : ".txt"),
+                                        this->histogramBinary_);
+    diagnostics.Write(file, std::move(histogram));
+    diagnostics.Close(file);
+  }
+
   void OutputGeometry()
   {
-    std::ofstream partnersOutFile(this->outputPrefix_.string() + "_partners.out");
-    for (auto partner : this->edges_)
+    if (this->outputText_)
     {
-      partnersOutFile << partner[0] << " "
-                      << partner[1] << std::endl;
+      auto start = std::chrono::high_resolution_clock::now();
+      double start_cpu = ThreadCpuSeconds();
+      ResetPeakRss();
+      double pool_cpu = this->OutputGeometryText();
+      std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+      this->RecordStage("output-text", elapsed.count(), ThreadCpuSeconds() - start_cpu + pool_cpu);
     }
-    partnersOutFile.close();
-    std::ofstream verticesOutFile(this->outputPrefix_.string() + "_vertices.out");
-    for (auto vertexI = 0; vertexI < this->vertices_.size(); vertexI++)
+    if (this->outputBinary_)
     {
-      verticesOutFile << boost::lexical_cast<std::string>(this->vertices_[vertexI][0]) << " "
-                      << boost::lexical_cast<std::string>(this->vertices_[vertexI][1]) << " "
-                      << boost::lexical_cast<std::string>(this->vertices_[vertexI][2]) << " "
-                      << this->vertexEdgeCount_[vertexI] << std::endl;
+      auto start = std::chrono::high_resolution_clock::now();
+      double start_cpu = ThreadCpuSeconds();
+      ResetPeakRss();
+      this->OutputGeometryBinary();
+      std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+      this->RecordStage("output-binary", elapsed.count(), ThreadCpuSeconds() - start_cpu);
     }
-    verticesOutFile.close();
+  }
 
-    std::ofstream nodesToEdgesOutFile(this->outputPrefix_.string() + "_nodes_to_edges.out");
-    for (auto edges : this->node_to_edges_)
+  // Formats the three geometry files in chunks of rows on the thread pool, each
+  // chunk into its own buffer, and then writes the files concurrently in large
+  // blocks. Coordinates are written in their shortest round-trip exact form.
+  // Returns the CPU time spent on the thread pool.
+  double OutputGeometryText()
+  {
+    std::size_t const rowsPerChunk = 1 << 16;
+    auto chunkCount = [rowsPerChunk](std::size_t rows) { return (rows + rowsPerChunk - 1) / rowsPerChunk; };
+    std::vector<std::string> partnerChunks(chunkCount(this->edges_.size()));
+    std::vector<std::string> vertexChunks(chunkCount(this->vertices_.size()));
+    std::vector<std::string> nodesToEdgesChunks(chunkCount(this->node_to_edges_.size()));
+
+    ThreadPool pool(this->parallelJobs_);
+    for (std::size_t i_chunk = 0; i_chunk < partnerChunks.size(); ++i_chunk)
+      pool.Submit([this, i_chunk, rowsPerChunk, &partnerChunks]() {
+        std::string &buffer = partnerChunks[i_chunk];
+        std::size_t end = std::min(this->edges_.size(), (i_chunk + 1) * rowsPerChunk);
+        buffer.reserve((end - i_chunk * rowsPerChunk) * 16);
+        for (std::size_t i_edge = i_chunk * rowsPerChunk; i_edge < end; ++i_edge)
+        {
+          AppendNumber(buffer, this->edges_[i_edge][0]);
+          buffer += ' ';
+          AppendNumber(buffer, this->edges_[i_edge][1]);
+          buffer += '\n';
+        }
+      });
+    for (std::size_t i_chunk = 0; i_chunk < vertexChunks.size(); ++i_chunk)
+      pool.Submit([this, i_chunk, rowsPerChunk, &vertexChunks]() {
+        std::string &buffer = vertexChunks[i_chunk];
+        std::size_t end = std::min(this->vertices_.size(), (i_chunk + 1) * rowsPerChunk);
+        buffer.reserve((end - i_chunk * rowsPerChunk) * 64);
+        for (std::size_t vertexI = i_chunk * rowsPerChunk; vertexI < end; ++vertexI)
+        {
+          for (unsigned int dim = 0; dim < 3; ++dim)
+          {
+            AppendNumber(buffer, this->vertices_[vertexI][dim]);
+            buffer += ' ';
+          }
+          AppendNumber(buffer, this->vertexEdgeCount_[vertexI]);
+          buffer += '\n';
+        }
+      });
+    for (std::size_t i_chunk = 0; i_chunk < nodesToEdgesChunks.size(); ++i_chunk)
+      pool.Submit([this, i_chunk, rowsPerChunk, &nodesToEdgesChunks]() {
+        std::string &buffer = nodesToEdgesChunks[i_chunk];
+        std::size_t end = std::min(this->node_to_edges_.size(), (i_chunk + 1) * rowsPerChunk);
+        buffer.reserve((end - i_chunk * rowsPerChunk) * 32);
+        for (std::size_t i_node = i_chunk * rowsPerChunk; i_node < end; ++i_node)
+        {
+          for (auto edge : this->node_to_edges_[i_node])
+          {
+            AppendNumber(buffer, edge);
+            buffer += ' ';
+          }
+          buffer += '\n';
+        }
+      });
+    pool.Wait();
+
+    std::string prefix = this->outputPrefix_.string();
+    pool.Submit([&prefix, &partnerChunks]() { WriteTextChunks(prefix + "_partners.out", partnerChunks); });
+    pool.Submit([&prefix, &vertexChunks]() { WriteTextChunks(prefix + "_vertices.out", vertexChunks); });
+    pool.Submit([&prefix, &nodesToEdgesChunks]() { WriteTextChunks(prefix + "_nodes_to_edges.out", nodesToEdgesChunks); });
+    pool.Wait();
+    return pool.TaskCpuSeconds();
+  }
+
+  void OutputGeometryBinary()
+  {
+    // node to edges in CSR format
+    std::vector<std::uint64_t> nodeEdgeOffsets(this->node_to_edges_.size() + 1, 0);
+    std::vector<std::uint32_t> nodeEdgeIds;
+    for (unsigned int i_node = 0; i_node < this->node_to_edges_.size(); ++i_node)
+      nodeEdgeOffsets[i_node + 1] = nodeEdgeOffsets[i_node] + this->node_to_edges_[i_node].size();
+    nodeEdgeIds.reserve(nodeEdgeOffsets.back());
+    for (auto const &edges : this->node_to_edges_)
+      nodeEdgeIds.insert(nodeEdgeIds.end(), edges.begin(), edges.end());
+
+    std::vector<std::uint32_t> vertexOrders(this->vertexEdgeCount_.begin(), this->vertexEdgeCount_.end());
+    if (vertexOrders.size() != this->vertices_.size() || nodeEdgeOffsets.size() != this->vertices_.size() + 1)
+      throw "Error in binary geometry output: vertex orders or node to edges do not match the vertices.";
+
+    NetworkFile::Header header = NetworkFile::Header();
+    std::memcpy(header.magic, NetworkFile::magic, sizeof(header.magic));
+    header.version = NetworkFile::version;
+    header.byteOrderMark = NetworkFile::byteOrderMark;
+    header.vertexCount = this->vertices_.size();
+    header.edgeCount = this->edges_.size();
+    header.nodeEdgeCount = nodeEdgeIds.size();
+
+    void const *sections[NetworkFile::sectionCount] = {this->vertices_.data(), vertexOrders.data(), this->edges_.data(),
+                                                       nodeEdgeOffsets.data(), nodeEdgeIds.data()};
+    header.sectionSizes[NetworkFile::vertices] = this->vertices_.size() * sizeof(Point);
+    header.sectionSizes[NetworkFile::vertexOrders] = vertexOrders.size() * sizeof(std::uint32_t);
+    header.sectionSizes[NetworkFile::edges] = this->edges_.size() * sizeof(Edge);
+    header.sectionSizes[NetworkFile::nodeEdgeOffsets] = nodeEdgeOffsets.size() * sizeof(std::uint64_t);
+    header.sectionSizes[NetworkFile::nodeEdgeIds] = nodeEdgeIds.size() * sizeof(std::uint32_t);
+
+    std::uint64_t offset = NetworkFile::AlignSection(sizeof(NetworkFile::Header));
+    for (unsigned int i = 0; i < NetworkFile::sectionCount; ++i)
+    {
+      header.sectionOffsets[i] = offset;
+      header.sectionChecksums[i] = NetworkFile::Checksum(sections[i], header.sectionSizes[i]);
+      offset = NetworkFile::AlignSection(offset + header.sectionSizes[i]);
+    }
+    header.headerChecksum = NetworkFile::Checksum(&header, sizeof(header));
+
+    std::ofstream networkOutFile(this->outputPrefix_.string() + "_network.bin", std::ios::binary);
+    networkOutFile.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    std::uint64_t position = sizeof(header);
+    char const padding[8] = {};
+    for (unsigned int i = 0; i < NetworkFile::sectionCount; ++i)
     {
-      for (auto edge : edges)
-        nodesToEdgesOutFile << edge << " ";
-      nodesToEdgesOutFile << std::endl;
+      networkOutFile.write(padding, header.sectionOffsets[i] - position);
+      networkOutFile.write(static_cast<char const *>(sections[i]), header.sectionSizes[i]);
+      position = header.sectionOffsets[i] + header.sectionSizes[i];
     }
-    nodesToEdgesOutFile.close();
+    if (!networkOutFile)
+      throw "Error in binary geometry output: writing the network file failed.";
   }
 
   void ReadGeometry()
   {
-    this->edges_.clear();
-    this->vertexEdgeCount_.clear();
-    this->vertices_map_.clear();
-    this->vertices_.clear();
-    this->node_to_edges_.clear();
-    std::string row;
-    std::ifstream verticesFile = std::ifstream(this->inputPrefix_.string() + "_vertices.out");
-    auto rowI = 0;
-    while (!verticesFile.eof())
+    std::string binaryPath = this->inputPrefix_.string() + "_network.bin";
+    bool binary = boost::filesystem::exists(binaryPath);
+    auto start = std::chrono::high_resolution_clock::now();
+    double start_cpu = ThreadCpuSeconds();
+    ResetPeakRss();
+    if (binary)
+      this->ReadGeometryBinary(binaryPath);
+    else
+      this->ReadGeometryText();
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    this->RecordStage(binary ? "read-binary" : "read-text", elapsed.count(), ThreadCpuSeconds() - start_cpu,
+                      {{"vertices", this->vertices_.size()}, {"edges", this->edges_.size()}});
+  }
+
+  // Maps the binary network file into memory, validates it and copies every
+  // section with a single block copy into the network arrays.
+  void ReadGeometryBinary(std::string const &path)
+  {
+    boost::interprocess::file_mapping file(path.c_str(), boost::interprocess::read_only);
+    boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+    char const *data = static_cast<char const *>(region.get_address());
+    std::size_t size = region.get_size();
+
+    NetworkFile::Header header;
+    if (size < sizeof(header))
+      throw "Error in binary geometry loading: file is truncated.";
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, NetworkFile::magic, sizeof(header.magic)) != 0)
+      throw "Error in binary geometry loading: not a network file.";
+    if (header.byteOrderMark != NetworkFile::byteOrderMark)
+      throw "Error in binary geometry loading: file was written with a different byte order.";
+    if (header.version != NetworkFile::version)
+      throw "Error in binary geometry loading: unsupported file version.";
+    std::uint32_t headerChecksum = header.headerChecksum;
+    header.headerChecksum = 0;
+    if (NetworkFile::Checksum(&header, sizeof(header)) != headerChecksum)
+      throw "Error in binary geometry loading: header checksum mismatch.";
+
+    std::uint64_t expectedSizes[NetworkFile::sectionCount] = {
+        header.vertexCount * sizeof(Point), header.vertexCount * sizeof(std::uint32_t), header.edgeCount * sizeof(Edge),
+        (header.vertexCount + 1) * sizeof(std::uint64_t), header.nodeEdgeCount * sizeof(std::uint32_t)};
+    for (unsigned int i = 0; i < NetworkFile::sectionCount; ++i)
     {
-      std::getline(verticesFile, row);
-      if (row == "")
-        continue;
-      if (verticesFile.bad() || verticesFile.fail())
-        break;
-      std::stringstream s(row);
-      double d;
-      std::vector<double> vertex;
-      auto i = 0;
-      while (s >> d)
-        if (++i <= 3)
-          vertex.push_back(d);
-        else if (i > 3)
-          this->vertexEdgeCount_.push_back(d);
-        else
-          throw "Error in voronoi geometry loading.";
-      this->vertices_.push_back(vertex);
-      if (this->vertexEdgeCount_[rowI] != 0)
-        this->vertices_map_.emplace(rowI, vertex);
-      rowI++;
+      if (header.sectionSizes[i] != expectedSizes[i] || header.sectionOffsets[i] % 8 != 0 ||
+          header.sectionOffsets[i] > size || header.sectionSizes[i] > size - header.sectionOffsets[i])
+        throw "Error in binary geometry loading: invalid section layout.";
+      if (NetworkFile::Checksum(data + header.sectionOffsets[i], header.sectionSizes[i]) != header.sectionChecksums[i])
+        throw "Error in binary geometry loading: section checksum mismatch.";
     }
-    std::ifstream partnersFile = std::ifstream(this->inputPrefix_.string() + "_partners.out");
-    while (!partnersFile.eof())
+
+    this->vertices_.resize(header.vertexCount);
+    std::memcpy(this->vertices_.data(), data + header.sectionOffsets[NetworkFile::vertices],
+                header.sectionSizes[NetworkFile::vertices]);
+
+    std::uint32_t const *vertexOrders = reinterpret_cast<std::uint32_t const *>(data + header.sectionOffsets[NetworkFile::vertexOrders]);
+    this->vertexEdgeCount_.assign(vertexOrders, vertexOrders + header.vertexCount);
+
+    this->edges_.resize(header.edgeCount);
+    std::memcpy(this->edges_.data(), data + header.sectionOffsets[NetworkFile::edges],
+                header.sectionSizes[NetworkFile::edges]);
+    for (auto const &edge : this->edges_)
+      if (edge[0] >= header.vertexCount || edge[1] >= header.vertexCount)
+        throw "Error in binary geometry loading: edge refers to a missing vertex.";
+
+    std::uint64_t const *nodeEdgeOffsets = reinterpret_cast<std::uint64_t const *>(data + header.sectionOffsets[NetworkFile::nodeEdgeOffsets]);
+    std::uint32_t const *nodeEdgeIds = reinterpret_cast<std::uint32_t const *>(data + header.sectionOffsets[NetworkFile::nodeEdgeIds]);
+    for (std::uint64_t i_id = 0; i_id < header.nodeEdgeCount; ++i_id)
+      if (nodeEdgeIds[i_id] >= header.edgeCount)
+        throw "Error in binary geometry loading: node refers to a missing edge.";
+    this->node_to_edges_.resize(header.vertexCount);
+    for (std::uint64_t i_node = 0; i_node < header.vertexCount; ++i_node)
     {
-      std::getline(partnersFile, row);
-      if (row == "")
-        continue;
-      if (partnersFile.bad() || partnersFile.fail())
-        break;
-      std::stringstream s(row);
-      uint u;
-      std::vector<uint> partners;
-      while (s >> u)
-        partners.push_back(u);
-      this->edges_.push_back(partners);
+      if (nodeEdgeOffsets[i_node] > nodeEdgeOffsets[i_node + 1] || nodeEdgeOffsets[i_node + 1] > header.nodeEdgeCount)
+        throw "Error in binary geometry loading: invalid node to edge offsets.";
+      this->node_to_edges_[i_node].assign(nodeEdgeIds + nodeEdgeOffsets[i_node], nodeEdgeIds + nodeEdgeOffsets[i_node + 1]);
+    }
+
+    this->vertices_map_.clear();
+    for (unsigned int i_node = 0; i_node < this->vertices_.size(); ++i_node)
+      if (this->vertexEdgeCount_[i_node] != 0)
+        this->vertices_map_.emplace(i_node, this->vertices_[i_node]);
+  }
+
+  void ReadGeometryText()
+  {
+    auto vertexRows = ReadNumberRows<double>(this->inputPrefix_.string() + "_vertices.out", true, this->parallelJobs_);
+    auto partnerRows = ReadNumberRows<unsigned int>(this->inputPrefix_.string() + "_partners.out", true, this->parallelJobs_);
+    //! DO NOT skip empty rows; empty lines mean no edges for nodes (aka dead nodes)
+    auto nodesToEdgesRows = ReadNumberRows<unsigned int>(this->inputPrefix_.string() + "_nodes_to_edges.out", false, this->parallelJobs_);
+
+    this->vertices_.resize(vertexRows.RowCount());
+    this->vertexEdgeCount_.resize(vertexRows.RowCount());
+    this->vertices_map_.clear();
+    for (std::size_t i_row = 0; i_row < vertexRows.RowCount(); ++i_row)
+    {
+      if (vertexRows.RowSize(i_row) != 4)
+        throw "Error in voronoi geometry loading.";
+      double const *row = vertexRows.Row(i_row);
+      this->vertices_[i_row] = Point{{row[0], row[1], row[2]}};
+      this->vertexEdgeCount_[i_row] = row[3];
+      if (this->vertexEdgeCount_[i_row] != 0)
+        this->vertices_map_.emplace_hint(this->vertices_map_.end(), i_row, this->vertices_[i_row]);
     }
 
-    std::ifstream nodesToEdgesFile = std::ifstream(this->inputPrefix_.string() + "_nodes_to_edges.out");
-    while (!nodesToEdgesFile.eof())
+    for (std::size_t i_row = 0; i_row < partnerRows.RowCount(); ++i_row)
+      if (partnerRows.RowSize(i_row) != 2)
+        throw "Error in voronoi geometry loading: an edge needs exactly two vertex ids.";
+    this->edges_.resize(partnerRows.RowCount());
+    std::memcpy(this->edges_.data(), partnerRows.values.data(), partnerRows.values.size() * sizeof(unsigned int));
+    for (auto const &edge : this->edges_)
+      if (edge[0] >= this->vertices_.size() || edge[1] >= this->vertices_.size())
+        throw "Error in voronoi geometry loading: edge refers to a missing vertex.";
+
+    this->node_to_edges_.resize(nodesToEdgesRows.RowCount());
+    for (std::size_t i_row = 0; i_row < nodesToEdgesRows.RowCount(); ++i_row)
     {
-      std::getline(nodesToEdgesFile, row);
-      if (row == "") //! DO NOT continue; empty lines mean no edges for nodes (aka dead nodes)
-        ;
-      if (nodesToEdgesFile.bad() || nodesToEdgesFile.fail())
-        break;
-      std::stringstream s(row);
-      uint u;
-      std::vector<uint> edges;
-      while (s >> u)
-        edges.push_back(u);
-      this->node_to_edges_.push_back(edges);
+      unsigned int const *row = nodesToEdgesRows.Row(i_row);
+      for (std::size_t i_id = 0; i_id < nodesToEdgesRows.RowSize(i_row); ++i_id)
+        if (row[i_id] >= this->edges_.size())
+          throw "Error in voronoi geometry loading: node refers to a missing edge.";
+      this->node_to_edges_[i_row].assign(row, row + nodesToEdgesRows.RowSize(i_row));
     }
   }
 };
@@ -10,8 +10,9 @@
 # C++ compiler
 CXX=g++
 
-# Flags for the C++ compiler
-CFLAGS=-Wall -ansi -pedantic -O3
+# Flags for the C++ compiler. The -fopenmp flag enables the multithreaded
+# cell computation routines, and can be removed to build a serial library.
+CFLAGS=-Wall -ansi -pedantic -O3 -fopenmp
 
 # Relative include and library paths for compilation of the examples
 E_INC=-I../../src
@@ -0,0 +1,120 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_parallel.hh
+ * \brief Header file for computing the Voronoi cells of a container on
+ * several threads. */
+
+#ifndef VOROPP_C_PARALLEL_HH
+#define VOROPP_C_PARALLEL_HH
+
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "config.hh"
+#include "v_compute.hh"
+
+namespace voro {
+
+/** Computes the Voronoi cells of all particles visited by a loop class on
+ * several threads. The particles are first listed in loop order, and the list
+ * is split into one contiguous range per thread with the same number of
+ * particles, so that any loop class can be used. Every thread uses its own
+ * voro_compute and cell objects, so that the container is only read. The
+ * cells are computed in the same way as in a serial loop, and hence give
+ * identical results for any number of threads. If the library is built
+ * without OpenMP, all cells are computed on the calling thread.
+ *
+ * The function object is first called as f.init(n,nt) with the number of
+ * particles and threads, and then as f(t,m,computed,c,vl) for every particle,
+ * where t is the thread index, m is the position of the particle in the loop
+ * order, computed tells whether the cell could be computed, c is the cell, and
+ * vl is a copy of the loop class that refers to the particle. Within one
+ * thread, the particles are visited in loop order, and the particles of thread
+ * t all precede those of thread t+1.
+ * \param[in] con the container class to use.
+ * \param[in] (hx,hy,hz) the size of the search mask, as used by the container.
+ * \param[in] vl the loop class to use.
+ * \param[in] f the function object to call for every particle.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+template<class v_cell,class c_class,class c_loop,class f_cell>
+void compute_cells_parallel(c_class &con,int hx,int hy,int hz,c_loop &vl,f_cell &f,int threads) {
+
+	// List the particles in loop order, storing the block index, the
+	// position within the block, and the block coordinates
+	std::vector<int> pl;
+	if(vl.start()) do {
+		pl.push_back(vl.ijk);pl.push_back(vl.q);pl.push_back(vl.i);
+		pl.push_back(vl.j);pl.push_back(vl.k);
+	} while(vl.inc());
+	int n=pl.size()/5;
+
+	int nt=threads>0?threads:1;
+#ifdef _OPENMP
+	if(threads<=0) nt=omp_get_max_threads();
+#endif
+	f.init(n,nt);
+	if(n==0) return;
+
+#pragma omp parallel num_threads(nt)
+	{
+		int t=0,tn=1;
+#ifdef _OPENMP
+		t=omp_get_thread_num();tn=omp_get_num_threads();
+#endif
+		voro_compute<c_class> vc(con,hx,hy,hz);
+		v_cell c;
+		// The cast selects the copy constructor of the loop class,
+		// rather than its templated container constructor
+		c_loop tvl(static_cast<const c_loop&>(vl));
+
+		// Compute the cells of this thread's share of the particles
+		int m=int((long) n*t/tn),me=int((long) n*(t+1)/tn);
+		for(;m<me;m++) {
+			const int *pp=&pl[5*m];
+			tvl.ijk=*pp;tvl.q=pp[1];tvl.i=pp[2];tvl.j=pp[3];tvl.k=pp[4];
+			f(t,m,vc.compute_cell(c,tvl.ijk,tvl.q,tvl.i,tvl.j,tvl.k),c,tvl);
+		}
+	}
+}
+
+/** \brief Function object for compute_cells_parallel that discards the
+ * computed cells. */
+struct parallel_discard {
+	inline void init(int n,int nt) {}
+	template<class v_cell,class c_loop>
+	inline void operator()(int t,int m,bool computed,v_cell &c,c_loop &vl) {}
+};
+
+/** \brief Function object for compute_cells_parallel that sums the cell
+ * volumes.
+ *
+ * The volume of every particle is stored, and the volumes are summed in loop
+ * order afterwards, so that the sum is the same for any number of threads. */
+struct parallel_volume_sum {
+	/** The volume of every particle in loop order, zero if its cell
+	 * could not be computed. */
+	std::vector<double> vols;
+	inline void init(int n,int nt) {vols.assign(n,0);}
+	template<class v_cell,class c_loop>
+	inline void operator()(int t,int m,bool computed,v_cell &c,c_loop &vl) {
+		if(computed) vols[m]=c.volume();
+	}
+	/** Sums the stored volumes in loop order.
+	 * \return The sum of the volumes. */
+	inline double sum() {
+		double vol=0;
+		for(std::vector<double>::iterator it=vols.begin();it<vols.end();it++) vol+=*it;
+		return vol;
+	}
+};
+
+}
+
+#endif
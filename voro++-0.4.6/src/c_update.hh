@@ -0,0 +1,190 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_update.hh
+ * \brief Header file for the voro_update template, which moves and removes
+ * particles and recomputes only the Voronoi cells that change. */
+
+#ifndef VOROPP_C_UPDATE_HH
+#define VOROPP_C_UPDATE_HH
+
+#include <vector>
+#include <algorithm>
+
+#include "config.hh"
+#include "cell.hh"
+#include "container.hh"
+
+namespace voro {
+
+/** \brief A class for updating a tessellation after particles move.
+ *
+ * This class moves or removes single particles of a container or
+ * container_poly class and recomputes the Voronoi cells that are affected by
+ * the change. Removing a particle only alters the cells that shared a face with
+ * it, and inserting a particle only alters the cells that share a face with its
+ * new cell, so that after a move, the changed cells are those of the particle
+ * itself and of its neighbors before and after the move. These are recomputed
+ * with the same routine as a full tessellation, and hence give the same cells
+ * as a full recomputation, although removing a particle from a block reorders
+ * that block, which may change the numbering of the vertices.
+ *
+ * To find particles by ID, the class keeps an index from particle IDs to their
+ * positions in the container, built when the class is constructed. The IDs
+ * must therefore be non-negative and unique, and the index takes memory in
+ * proportion to the largest ID. While the class is in use, particles should
+ * only be added or removed through it. */
+template<class c_class>
+class voro_update {
+	public:
+		/** The IDs of the particles whose cells were recomputed by the
+		 * last update, in increasing order. */
+		std::vector<int> changed;
+		/** The recomputed cells, so that the first changed.size()
+		 * entries hold the cells of the particles in the changed
+		 * array. A cell that could not be computed has no vertices.
+		 * The entries are kept between updates, so that their memory
+		 * is reused. */
+		std::vector<cell_extract> cells;
+		/** The class constructor builds the index of the particles that
+		 * are currently in the container.
+		 * \param[in] con_ the container class to update. */
+		voro_update(c_class &con_) : con(con_) {
+			for(int ijk=0;ijk<con.nxyz;ijk++)
+				for(int q=0;q<con.co[ijk];q++) set_index(con.id[ijk][q],ijk,q);
+		}
+		/** Moves a particle to a new position, and recomputes the cells
+		 * of the particle and of its neighbors before and after the
+		 * move. Any additional floating point information about the
+		 * particle, such as its radius, is kept.
+		 * \param[in] n the ID of the particle to move.
+		 * \param[in] (x,y,z) the new position of the particle.
+		 * \return True if the particle was moved, false if the ID is
+		 * not in the container or if the new position is outside the
+		 * container, in which case the particle is removed. */
+		bool move(int n,double x,double y,double z) {
+			int ijk,q,l;
+			changed.clear();
+			if(!find(n,ijk,q)) return false;
+			add_neighbors(n,ijk,q);
+			double e[4];
+			for(l=3;l<con.ps;l++) e[l]=con.p[ijk][con.ps*q+l];
+			take_out(ijk,q);
+			if(!con.put_locate_block(ijk,x,y,z)) {
+				loc_ijk[n]=-1;
+				changed.erase(std::remove(changed.begin(),changed.end(),n),changed.end());
+				recompute();
+				return false;
+			}
+			q=con.co[ijk]++;
+			con.id[ijk][q]=n;
+			double *pp=con.p[ijk]+con.ps*q;
+			*(pp++)=x;*(pp++)=y;*(pp++)=z;
+			for(l=3;l<con.ps;l++) *(pp++)=e[l];
+			set_index(n,ijk,q);
+			add_neighbors(n,ijk,q);
+			recompute();
+			return true;
+		}
+		/** Removes a particle from the container, and recomputes the
+		 * cells of its former neighbors.
+		 * \param[in] n the ID of the particle to remove.
+		 * \return True if the particle was removed, false if the ID is
+		 * not in the container. */
+		bool remove(int n) {
+			int ijk,q;
+			changed.clear();
+			if(!find(n,ijk,q)) return false;
+			add_neighbors(n,ijk,q);
+			take_out(ijk,q);
+			loc_ijk[n]=-1;
+			changed.erase(std::remove(changed.begin(),changed.end(),n),changed.end());
+			recompute();
+			return true;
+		}
+		/** Looks up the position of a particle in the container.
+		 * \param[in] n the ID of the particle.
+		 * \param[out] (ijk,q) the block and the index within the block
+		 *                     of the particle.
+		 * \return True if the particle is in the container, false
+		 * otherwise. */
+		inline bool find(int n,int &ijk,int &q) {
+			if(n<0||n>=(int) loc_ijk.size()||loc_ijk[n]<0) return false;
+			ijk=loc_ijk[n];q=loc_q[n];
+			return true;
+		}
+	private:
+		/** A reference to the container class. */
+		c_class &con;
+		/** The block of every particle, indexed by ID, or -1 if there
+		 * is no such particle. */
+		std::vector<int> loc_ijk;
+		/** The index within its block of every particle, indexed by
+		 * ID. */
+		std::vector<int> loc_q;
+		/** A cell to compute the neighbors and the changed cells. */
+		voronoicell_neighbor c;
+		/** Temporary storage for the neighbors of a cell. */
+		std::vector<int> nb;
+		/** Records the position of a particle in the index.
+		 * \param[in] n the ID of the particle.
+		 * \param[in] (ijk,q) the block and the index within the block
+		 *                    of the particle. */
+		inline void set_index(int n,int ijk,int q) {
+			if(n<0) voro_fatal_error("Particle IDs must be non-negative to update the container",VOROPP_INTERNAL_ERROR);
+			if(n>=(int) loc_ijk.size()) {
+				loc_ijk.resize(n+1,-1);loc_q.resize(n+1);
+			}
+			loc_ijk[n]=ijk;loc_q[n]=q;
+		}
+		/** Removes a particle from its block by moving the last particle
+		 * of the block into its place.
+		 * \param[in] (ijk,q) the block and the index within the block
+		 *                    of the particle. */
+		inline void take_out(int ijk,int q) {
+			int l=--con.co[ijk];
+			if(q<l) {
+				con.id[ijk][q]=con.id[ijk][l];
+				double *pp=con.p[ijk]+con.ps*q,*pe=pp+con.ps,*pl=con.p[ijk]+con.ps*l;
+				while(pp<pe) *(pp++)=*(pl++);
+				loc_q[con.id[ijk][q]]=q;
+			}
+		}
+		/** Computes the cell of a particle and adds it and its
+		 * neighbors to the list of changed particles. Neighbors with
+		 * negative IDs, which are walls or the container boundary, are
+		 * skipped.
+		 * \param[in] n the ID of the particle.
+		 * \param[in] (ijk,q) the block and the index within the block
+		 *                    of the particle. */
+		inline void add_neighbors(int n,int ijk,int q) {
+			changed.push_back(n);
+			if(!con.compute_cell(c,ijk,q)) return;
+			c.neighbors(nb);
+			for(std::vector<int>::iterator it=nb.begin();it<nb.end();it++)
+				if(*it>=0) changed.push_back(*it);
+		}
+		/** Sorts the list of changed particles, removes duplicates, and
+		 * recomputes their cells. */
+		void recompute() {
+			std::sort(changed.begin(),changed.end());
+			changed.erase(std::unique(changed.begin(),changed.end()),changed.end());
+			if(cells.size()<changed.size()) cells.resize(changed.size());
+			int ijk,q;
+			for(unsigned int l=0;l<changed.size();l++) {
+				cell_extract &e=cells[l];
+				find(changed[l],ijk,q);
+				if(con.compute_cell(c,ijk,q)) {
+					double *pp=con.p[ijk]+con.ps*q;
+					c.extract(*pp,pp[1],pp[2],e);
+				} else e.clear();
+			}
+		}
+};
+
+}
+
+#endif
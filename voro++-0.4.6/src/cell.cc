@@ -8,44 +8,73 @@
  * \brief Function implementations for the voronoicell and related classes. */
 
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
 #include "config.hh"
 #include "common.hh"
 #include "cell.hh"
+#include "custom_format.hh"
 
 namespace voro {
 
+/** Allocates the array for the vertex positions.
+ * \param[in] n the number of vertices to make space for.
+ * \return A pointer to the array. */
+static inline double* new_pts(int n) {
+#if VOROPP_SOA==1
+	void *q;
+	if(posix_memalign(&q,32,3*n*sizeof(double))!=0)
+		voro_fatal_error("Vertex position allocation failed",VOROPP_MEMORY_ERROR);
+	return (double*) q;
+#else
+	return new double[3*n];
+#endif
+}
+
+/** Frees an array allocated with new_pts.
+ * \param[in] q a pointer to the array. */
+static inline void delete_pts(double *q) {
+#if VOROPP_SOA==1
+	free(q);
+#else
+	delete [] q;
+#endif
+}
+
 /** Constructs a Voronoi cell and sets up the initial memory. */
 voronoicell_base::voronoicell_base() :
 	current_vertices(init_vertices), current_vertex_order(init_vertex_order),
 	current_delete_size(init_delete_size), current_delete2_size(init_delete2_size),
 	ed(new int*[current_vertices]), nu(new int[current_vertices]),
-	pts(new double[3*current_vertices]), mem(new int[current_vertex_order]),
+	pts(new_pts(current_vertices)), mem(new int[current_vertex_order]),
 	mec(new int[current_vertex_order]), mep(new int*[current_vertex_order]),
 	ds(new int[current_delete_size]), stacke(ds+current_delete_size),
 	ds2(new int[current_delete2_size]), stacke2(ds2+current_delete_size),
 	current_marginal(init_marginal), marg(new int[current_marginal]) {
-	int i;
-	for(i=0;i<3;i++) {
-		mem[i]=init_n_vertices;mec[i]=0;
-		mep[i]=new int[init_n_vertices*((i<<1)+1)];
+	int i,s=0;
+	for(i=0;i<current_vertex_order;i++) {
+		mem[i]=init_mem(i);mec[i]=0;
+		s+=mem[i]*((i<<1)+1);
 	}
-	mem[3]=init_3_vertices;mec[3]=0;
-	mep[3]=new int[init_3_vertices*7];
-	for(i=4;i<current_vertex_order;i++) {
-		mem[i]=init_n_vertices;mec[i]=0;
-		mep[i]=new int[init_n_vertices*((i<<1)+1)];
+
+	// Carve the initial arrays for all orders out of one block, so that
+	// constructing a cell only needs a handful of allocations
+	mep_pool=new int[s];
+	for(s=i=0;i<current_vertex_order;i++) {
+		mep[i]=mep_pool+s;
+		s+=mem[i]*((i<<1)+1);
 	}
 }
 
 /** The voronoicell destructor deallocates all the dynamic memory. */
 voronoicell_base::~voronoicell_base() {
-	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0) delete [] mep[i];
+	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0&&!pooled(i)) delete [] mep[i];
+	delete [] mep_pool;
 	delete [] marg;
 	delete [] ds2;delete [] ds;
 	delete [] mep;delete [] mec;
-	delete [] mem;delete [] pts;
+	delete [] mem;delete_pts(pts);
 	delete [] nu;delete [] ed;
 }
 
@@ -71,7 +100,7 @@ void voronoicell_base::copy(voronoicell_base* vb) {
 		for(j=0;j<mec[i]*(2*i+1);j+=2*i+1) ed[mep[i][j+2*i]]=mep[i]+j;
 	}
 	for(i=0;i<p;i++) nu[i]=vb->nu[i];
-	for(i=0;i<3*p;i++) pts[i]=vb->pts[i];
+	for(i=0;i<p;i++) {pt(i,0)=vb->pt(i,0);pt(i,1)=vb->pt(i,1);pt(i,2)=vb->pt(i,2);}
 }
 
 /** Copies the information from another voronoicell class into this
@@ -100,13 +129,21 @@ void voronoicell_neighbor::operator=(voronoicell_neighbor &c) {
 	}
 }
 
+/** Empties the cell, while keeping all of the memory that has been allocated
+ * for it. The init routines reuse this memory too, so a single cell object can
+ * be used for many successive cell computations without further allocation
+ * once its arrays have grown to a sufficient size. */
+void voronoicell_base::reset() {
+	for(int i=0;i<current_vertex_order;i++) mec[i]=0;
+	p=up=0;
+}
+
 /** Translates the vertices of the Voronoi cell by a given vector.
  * \param[in] (x,y,z) the coordinates of the vector. */
 void voronoicell_base::translate(double x,double y,double z) {
 	x*=2;y*=2;z*=2;
-	double *ptsp=pts;
-	while(ptsp<pts+3*p) {
-		*(ptsp++)=x;*(ptsp++)=y;*(ptsp++)=z;
+	for(int i=0;i<p;i++) {
+		pt(i,0)=x;pt(i,1)=y;pt(i,2)=z;
 	}
 }
 
@@ -133,6 +170,7 @@ void voronoicell_base::add_memory(vc_class &vc,int i,int *stackp2) {
 #endif
 	} else {
 		int j=0,k,*l;
+		bool pl=pooled(i);
 		mem[i]<<=1;
 		if(mem[i]>max_n_vertices) voro_fatal_error("Point memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
 #if VOROPP_VERBOSE >=2
@@ -163,9 +201,9 @@ void voronoicell_base::add_memory(vc_class &vc,int i,int *stackp2) {
 			for(k=0;k<s;k++,j++) l[j]=mep[i][j];
 			for(k=0;k<i;k++,m++) vc.n_copy_to_aux1(i,m);
 		}
-		delete [] mep[i];
+		if(!pl) delete [] mep[i];
 		mep[i]=l;
-		vc.n_switch_to_aux1(i);
+		vc.n_switch_to_aux1(i,pl);
 	}
 }
 
@@ -189,9 +227,17 @@ void voronoicell_base::add_memory_vertices(vc_class &vc) {
 	pnu=new int[i];
 	for(j=0;j<current_vertices;j++) pnu[j]=nu[j];
 	delete [] nu;nu=pnu;
-	ppts=new double[3*i];
+	ppts=new_pts(i);
+#if VOROPP_SOA==1
+	for(j=0;j<current_vertices;j++) {
+		ppts[j]=pts[j];
+		ppts[i+j]=pts[current_vertices+j];
+		ppts[2*i+j]=pts[2*current_vertices+j];
+	}
+#else
 	for(j=0;j<3*current_vertices;j++) ppts[j]=pts[j];
-	delete [] pts;pts=ppts;
+#endif
+	delete_pts(pts);pts=ppts;
 	current_vertices=i;
 }
 
@@ -257,14 +303,14 @@ void voronoicell_base::add_memory_ds2(int *&stackp2) {
 void voronoicell_base::init_base(double xmin,double xmax,double ymin,double ymax,double zmin,double zmax) {
 	for(int i=0;i<current_vertex_order;i++) mec[i]=0;up=0;
 	mec[3]=p=8;xmin*=2;xmax*=2;ymin*=2;ymax*=2;zmin*=2;zmax*=2;
-	*pts=xmin;pts[1]=ymin;pts[2]=zmin;
-	pts[3]=xmax;pts[4]=ymin;pts[5]=zmin;
-	pts[6]=xmin;pts[7]=ymax;pts[8]=zmin;
-	pts[9]=xmax;pts[10]=ymax;pts[11]=zmin;
-	pts[12]=xmin;pts[13]=ymin;pts[14]=zmax;
-	pts[15]=xmax;pts[16]=ymin;pts[17]=zmax;
-	pts[18]=xmin;pts[19]=ymax;pts[20]=zmax;
-	pts[21]=xmax;pts[22]=ymax;pts[23]=zmax;
+	pt(0,0)=xmin;pt(0,1)=ymin;pt(0,2)=zmin;
+	pt(1,0)=xmax;pt(1,1)=ymin;pt(1,2)=zmin;
+	pt(2,0)=xmin;pt(2,1)=ymax;pt(2,2)=zmin;
+	pt(3,0)=xmax;pt(3,1)=ymax;pt(3,2)=zmin;
+	pt(4,0)=xmin;pt(4,1)=ymin;pt(4,2)=zmax;
+	pt(5,0)=xmax;pt(5,1)=ymin;pt(5,2)=zmax;
+	pt(6,0)=xmin;pt(6,1)=ymax;pt(6,2)=zmax;
+	pt(7,0)=xmax;pt(7,1)=ymax;pt(7,2)=zmax;
 	int *q=mep[3];
 	*q=1;q[1]=4;q[2]=2;q[3]=2;q[4]=1;q[5]=0;q[6]=0;
 	q[7]=3;q[8]=5;q[9]=0;q[10]=2;q[11]=1;q[12]=0;q[13]=1;
@@ -286,12 +332,12 @@ void voronoicell_base::init_base(double xmin,double xmax,double ymin,double ymax
 void voronoicell_base::init_octahedron_base(double l) {
 	for(int i=0;i<current_vertex_order;i++) mec[i]=0;up=0;
 	mec[4]=p=6;l*=2;
-	*pts=-l;pts[1]=0;pts[2]=0;
-	pts[3]=l;pts[4]=0;pts[5]=0;
-	pts[6]=0;pts[7]=-l;pts[8]=0;
-	pts[9]=0;pts[10]=l;pts[11]=0;
-	pts[12]=0;pts[13]=0;pts[14]=-l;
-	pts[15]=0;pts[16]=0;pts[17]=l;
+	pt(0,0)=-l;pt(0,1)=0;pt(0,2)=0;
+	pt(1,0)=l;pt(1,1)=0;pt(1,2)=0;
+	pt(2,0)=0;pt(2,1)=-l;pt(2,2)=0;
+	pt(3,0)=0;pt(3,1)=l;pt(3,2)=0;
+	pt(4,0)=0;pt(4,1)=0;pt(4,2)=-l;
+	pt(5,0)=0;pt(5,1)=0;pt(5,2)=l;
 	int *q=mep[4];
 	*q=2;q[1]=5;q[2]=3;q[3]=4;q[4]=0;q[5]=0;q[6]=0;q[7]=0;q[8]=0;
 	q[9]=2;q[10]=4;q[11]=3;q[12]=5;q[13]=2;q[14]=2;q[15]=2;q[16]=2;q[17]=1;
@@ -312,10 +358,10 @@ void voronoicell_base::init_octahedron_base(double l) {
 void voronoicell_base::init_tetrahedron_base(double x0,double y0,double z0,double x1,double y1,double z1,double x2,double y2,double z2,double x3,double y3,double z3) {
 	for(int i=0;i<current_vertex_order;i++) mec[i]=0;up=0;
 	mec[3]=p=4;
-	*pts=x0*2;pts[1]=y0*2;pts[2]=z0*2;
-	pts[3]=x1*2;pts[4]=y1*2;pts[5]=z1*2;
-	pts[6]=x2*2;pts[7]=y2*2;pts[8]=z2*2;
-	pts[9]=x3*2;pts[10]=y3*2;pts[11]=z3*2;
+	pt(0,0)=x0*2;pt(0,1)=y0*2;pt(0,2)=z0*2;
+	pt(1,0)=x1*2;pt(1,1)=y1*2;pt(1,2)=z1*2;
+	pt(2,0)=x2*2;pt(2,1)=y2*2;pt(2,2)=z2*2;
+	pt(3,0)=x3*2;pt(3,1)=y3*2;pt(3,2)=z3*2;
 	int *q=mep[3];
 	*q=1;q[1]=3;q[2]=2;q[3]=0;q[4]=0;q[5]=0;q[6]=0;
 	q[7]=0;q[8]=2;q[9]=3;q[10]=0;q[11]=2;q[12]=1;q[13]=1;
@@ -594,9 +640,9 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 		// The search algorithm found a point which is on the cutting
 		// plane. We leave that point in place, and create a new one at
 		// the same location.
-		pts[3*p]=pts[3*up];
-		pts[3*p+1]=pts[3*up+1];
-		pts[3*p+2]=pts[3*up+2];
+		pt(p,0)=pt(up,0);
+		pt(p,1)=pt(up,1);
+		pt(p,2)=pt(up,2);
 
 		// Search for a collection of edges of the test vertex which
 		// are outside of the cutting space. Begin by testing the
@@ -780,9 +826,9 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 		if(stackp==stacke) add_memory_ds(stackp);
 		*(stackp++)=up;
 		r=u/(u-l);l=1-r;
-		pts[3*p]=pts[3*lp]*r+pts[3*up]*l;
-		pts[3*p+1]=pts[3*lp+1]*r+pts[3*up+1]*l;
-		pts[3*p+2]=pts[3*lp+2]*r+pts[3*up+2]*l;
+		pt(p,0)=pt(lp,0)*r+pt(up,0)*l;
+		pt(p,1)=pt(lp,1)*r+pt(up,1)*l;
+		pt(p,2)=pt(lp,2)*r+pt(up,2)*l;
 
 		// This point will always have three edges. Connect one of them
 		// to lp.
@@ -836,9 +882,9 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 			// new point in the facet we're constructing.
 			if(p==current_vertices) add_memory_vertices(vc);
 			r=q/(q-l);l=1-r;
-			pts[3*p]=pts[3*lp]*r+pts[3*qp]*l;
-			pts[3*p+1]=pts[3*lp+1]*r+pts[3*qp+1]*l;
-			pts[3*p+2]=pts[3*lp+2]*r+pts[3*qp+2]*l;
+			pt(p,0)=pt(lp,0)*r+pt(qp,0)*l;
+			pt(p,1)=pt(lp,1)*r+pt(qp,1)*l;
+			pt(p,2)=pt(lp,2)*r+pt(qp,2)*l;
 			nu[p]=3;
 			if(mec[3]==mem[3]) add_memory(vc,3,stackp2);
 			ls=ed[qp][qs+nu[qp]];
@@ -1007,9 +1053,9 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 				ed[p][k<<1]=p;
 				if(stackp2==stacke2) add_memory_ds2(stackp2);
 				*(stackp2++)=qp;
-				pts[3*p]=pts[3*qp];
-				pts[3*p+1]=pts[3*qp+1];
-				pts[3*p+2]=pts[3*qp+2];
+				pt(p,0)=pt(qp,0);
+				pt(p,1)=pt(qp,1);
+				pt(p,2)=pt(qp,2);
 				ed[qp][nu[qp]<<1]=-p;
 				j=p++;
 				i=0;
@@ -1115,9 +1161,9 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 		if(up<p) {
 
 			// Vertex management
-			pts[3*up]=pts[3*p];
-			pts[3*up+1]=pts[3*p+1];
-			pts[3*up+2]=pts[3*p+2];
+			pt(up,0)=pt(p,0);
+			pt(up,1)=pt(p,1);
+			pt(up,2)=pt(p,2);
 
 			// Memory management
 			j=nu[up];
@@ -1193,9 +1239,9 @@ inline bool voronoicell_base::collapse_order2(vc_class &vc) {
 		if(up==i) up=0;
 		if(p!=i) {
 			if(up==p) up=i;
-			pts[3*i]=pts[3*p];
-			pts[3*i+1]=pts[3*p+1];
-			pts[3*i+2]=pts[3*p+2];
+			pt(i,0)=pt(p,0);
+			pt(i,1)=pt(p,1);
+			pt(i,2)=pt(p,2);
 			for(k=0;k<nu[p];k++) ed[ed[p][k]][ed[p][nu[p]+k]]=i;
 			vc.n_copy_pointer(i,p);
 			ed[i]=ed[p];
@@ -1230,9 +1276,9 @@ inline bool voronoicell_base::collapse_order1(vc_class &vc) {
 		if(up==i) up=0;
 		if(p!=i) {
 			if(up==p) up=i;
-			pts[3*i]=pts[3*p];
-			pts[3*i+1]=pts[3*p+1];
-			pts[3*i+2]=pts[3*p+2];
+			pt(i,0)=pt(p,0);
+			pt(i,1)=pt(p,1);
+			pt(i,2)=pt(p,2);
 			for(k=0;k<nu[p];k++) ed[ed[p][k]][ed[p][nu[p]+k]]=i;
 			vc.n_copy_pointer(i,p);
 			ed[i]=ed[p];
@@ -1302,23 +1348,23 @@ double voronoicell_base::volume() {
 	int i,j,k,l,m,n;
 	double ux,uy,uz,vx,vy,vz,wx,wy,wz;
 	for(i=1;i<p;i++) {
-		ux=*pts-pts[3*i];
-		uy=pts[1]-pts[3*i+1];
-		uz=pts[2]-pts[3*i+2];
+		ux=pt(0,0)-pt(i,0);
+		uy=pt(0,1)-pt(i,1);
+		uz=pt(0,2)-pt(i,2);
 		for(j=0;j<nu[i];j++) {
 			k=ed[i][j];
 			if(k>=0) {
 				ed[i][j]=-1-k;
 				l=cycle_up(ed[i][nu[i]+j],k);
-				vx=pts[3*k]-*pts;
-				vy=pts[3*k+1]-pts[1];
-				vz=pts[3*k+2]-pts[2];
+				vx=pt(k,0)-pt(0,0);
+				vy=pt(k,1)-pt(0,1);
+				vz=pt(k,2)-pt(0,2);
 				m=ed[k][l];ed[k][l]=-1-m;
 				while(m!=i) {
 					n=cycle_up(ed[k][nu[k]+l],m);
-					wx=pts[3*m]-*pts;
-					wy=pts[3*m+1]-pts[1];
-					wz=pts[3*m+2]-pts[2];
+					wx=pt(m,0)-pt(0,0);
+					wy=pt(m,1)-pt(0,1);
+					wz=pt(m,2)-pt(0,2);
 					vol+=ux*vy*wz+uy*vz*wx+uz*vx*wy-uz*vy*wx-uy*vx*wz-ux*vz*wy;
 					k=m;l=n;vx=wx;vy=wy;vz=wz;
 					m=ed[k][l];ed[k][l]=-1-m;
@@ -1347,12 +1393,12 @@ void voronoicell_base::face_areas(std::vector<double> &v) {
 			m=ed[k][l];ed[k][l]=-1-m;
 			while(m!=i) {
 				n=cycle_up(ed[k][nu[k]+l],m);
-				ux=pts[3*k]-pts[3*i];
-				uy=pts[3*k+1]-pts[3*i+1];
-				uz=pts[3*k+2]-pts[3*i+2];
-				vx=pts[3*m]-pts[3*i];
-				vy=pts[3*m+1]-pts[3*i+1];
-				vz=pts[3*m+2]-pts[3*i+2];
+				ux=pt(k,0)-pt(i,0);
+				uy=pt(k,1)-pt(i,1);
+				uz=pt(k,2)-pt(i,2);
+				vx=pt(m,0)-pt(i,0);
+				vy=pt(m,1)-pt(i,1);
+				vz=pt(m,2)-pt(i,2);
 				wx=uy*vz-uz*vy;
 				wy=uz*vx-ux*vz;
 				wz=ux*vy-uy*vx;
@@ -1381,12 +1427,12 @@ double voronoicell_base::surface_area() {
 			m=ed[k][l];ed[k][l]=-1-m;
 			while(m!=i) {
 				n=cycle_up(ed[k][nu[k]+l],m);
-				ux=pts[3*k]-pts[3*i];
-				uy=pts[3*k+1]-pts[3*i+1];
-				uz=pts[3*k+2]-pts[3*i+2];
-				vx=pts[3*m]-pts[3*i];
-				vy=pts[3*m+1]-pts[3*i+1];
-				vz=pts[3*m+2]-pts[3*i+2];
+				ux=pt(k,0)-pt(i,0);
+				uy=pt(k,1)-pt(i,1);
+				uz=pt(k,2)-pt(i,2);
+				vx=pt(m,0)-pt(i,0);
+				vy=pt(m,1)-pt(i,1);
+				vz=pt(m,2)-pt(i,2);
 				wx=uy*vz-uz*vy;
 				wy=uz*vx-ux*vz;
 				wz=ux*vy-uy*vx;
@@ -1410,23 +1456,23 @@ void voronoicell_base::centroid(double &cx,double &cy,double &cz) {
 	int i,j,k,l,m,n;
 	double ux,uy,uz,vx,vy,vz,wx,wy,wz;
 	for(i=1;i<p;i++) {
-		ux=*pts-pts[3*i];
-		uy=pts[1]-pts[3*i+1];
-		uz=pts[2]-pts[3*i+2];
+		ux=pt(0,0)-pt(i,0);
+		uy=pt(0,1)-pt(i,1);
+		uz=pt(0,2)-pt(i,2);
 		for(j=0;j<nu[i];j++) {
 			k=ed[i][j];
 			if(k>=0) {
 				ed[i][j]=-1-k;
 				l=cycle_up(ed[i][nu[i]+j],k);
-				vx=pts[3*k]-*pts;
-				vy=pts[3*k+1]-pts[1];
-				vz=pts[3*k+2]-pts[2];
+				vx=pt(k,0)-pt(0,0);
+				vy=pt(k,1)-pt(0,1);
+				vz=pt(k,2)-pt(0,2);
 				m=ed[k][l];ed[k][l]=-1-m;
 				while(m!=i) {
 					n=cycle_up(ed[k][nu[k]+l],m);
-					wx=pts[3*m]-*pts;
-					wy=pts[3*m+1]-pts[1];
-					wz=pts[3*m+2]-pts[2];
+					wx=pt(m,0)-pt(0,0);
+					wy=pt(m,1)-pt(0,1);
+					wz=pt(m,2)-pt(0,2);
 					tvol=ux*vy*wz+uy*vz*wx+uz*vx*wy-uz*vy*wx-uy*vx*wz-ux*vz*wy;
 					vol+=tvol;
 					cx+=(wx+vx-ux)*tvol;
@@ -1441,9 +1487,9 @@ void voronoicell_base::centroid(double &cx,double &cy,double &cz) {
 	reset_edges();
 	if(vol>tolerance_sq) {
 		vol=0.125/vol;
-		cx=cx*vol+0.5*(*pts);
-		cy=cy*vol+0.5*pts[1];
-		cz=cz*vol+0.5*pts[2];
+		cx=cx*vol+0.5*pt(0,0);
+		cy=cy*vol+0.5*pt(0,1);
+		cz=cz*vol+0.5*pt(0,2);
 	} else cx=cy=cz=0;
 }
 
@@ -1452,12 +1498,9 @@ void voronoicell_base::centroid(double &cx,double &cy,double &cz) {
  * all planes that could cut the cell have been considered.
  * \return The maximum radius squared of a vertex.*/
 double voronoicell_base::max_radius_squared() {
-	double r,s,*ptsp=pts+3,*ptse=pts+3*p;
-	r=*pts*(*pts)+pts[1]*pts[1]+pts[2]*pts[2];
-	while(ptsp<ptse) {
-		s=*ptsp*(*ptsp);ptsp++;
-		s+=*ptsp*(*ptsp);ptsp++;
-		s+=*ptsp*(*ptsp);ptsp++;
+	double r=pt(0,0)*pt(0,0)+pt(0,1)*pt(0,1)+pt(0,2)*pt(0,2),s;
+	for(int i=1;i<p;i++) {
+		s=pt(i,0)*pt(i,0);s+=pt(i,1)*pt(i,1);s+=pt(i,2)*pt(i,2);
 		if(s>r) r=s;
 	}
 	return r;
@@ -1471,9 +1514,9 @@ double voronoicell_base::total_edge_distance() {
 	for(i=0;i<p-1;i++) for(j=0;j<nu[i];j++) {
 		k=ed[i][j];
 		if(k>i) {
-			dx=pts[3*k]-pts[3*i];
-			dy=pts[3*k+1]-pts[3*i+1];
-			dz=pts[3*k+2]-pts[3*i+2];
+			dx=pt(k,0)-pt(i,0);
+			dy=pt(k,1)-pt(i,1);
+			dz=pt(k,2)-pt(i,2);
 			dis+=sqrt(dx*dx+dy*dy+dz*dz);
 		}
 	}
@@ -1485,16 +1528,15 @@ double voronoicell_base::total_edge_distance() {
  * \param[in] (x,y,z) a displacement vector to be added to the cell's position.
  * \param[in] fp a file handle to write to. */
 void voronoicell_base::draw_pov(double x,double y,double z,FILE* fp) {
-	int i,j,k;double *ptsp=pts,*pt2;
+	int i,j,k;
 	char posbuf1[128],posbuf2[128];
-	for(i=0;i<p;i++,ptsp+=3) {
-		sprintf(posbuf1,"%g,%g,%g",x+*ptsp*0.5,y+ptsp[1]*0.5,z+ptsp[2]*0.5);
+	for(i=0;i<p;i++) {
+		sprintf(posbuf1,"%g,%g,%g",x+pt(i,0)*0.5,y+pt(i,1)*0.5,z+pt(i,2)*0.5);
 		fprintf(fp,"sphere{<%s>,r}\n",posbuf1);
 		for(j=0;j<nu[i];j++) {
 			k=ed[i][j];
 			if(k<i) {
-				pt2=pts+3*k;
-				sprintf(posbuf2,"%g,%g,%g",x+*pt2*0.5,y+0.5*pt2[1],z+0.5*pt2[2]);
+				sprintf(posbuf2,"%g,%g,%g",x+pt(k,0)*0.5,y+0.5*pt(k,1),z+0.5*pt(k,2));
 				if(strcmp(posbuf1,posbuf2)!=0) fprintf(fp,"cylinder{<%s>,<%s>,r}\n",posbuf1,posbuf2);
 			}
 		}
@@ -1509,13 +1551,13 @@ void voronoicell_base::draw_gnuplot(double x,double y,double z,FILE *fp) {
 	for(i=1;i<p;i++) for(j=0;j<nu[i];j++) {
 		k=ed[i][j];
 		if(k>=0) {
-			fprintf(fp,"%g %g %g\n",x+0.5*pts[3*i],y+0.5*pts[3*i+1],z+0.5*pts[3*i+2]);
+			fprintf(fp,"%g %g %g\n",x+0.5*pt(i,0),y+0.5*pt(i,1),z+0.5*pt(i,2));
 			l=i;m=j;
 			do {
 				ed[k][ed[l][nu[l]+m]]=-1-l;
 				ed[l][m]=-1-k;
 				l=k;
-				fprintf(fp,"%g %g %g\n",x+0.5*pts[3*k],y+0.5*pts[3*k+1],z+0.5*pts[3*k+2]);
+				fprintf(fp,"%g %g %g\n",x+0.5*pt(k,0),y+0.5*pt(k,1),z+0.5*pt(k,2));
 			} while (search_edge(l,m,k));
 			fputs("\n\n",fp);
 		}
@@ -1541,9 +1583,8 @@ inline bool voronoicell_base::search_edge(int l,int &m,int &k) {
  * \param[in] fp a file handle to write to. */
 void voronoicell_base::draw_pov_mesh(double x,double y,double z,FILE *fp) {
 	int i,j,k,l,m,n;
-	double *ptsp=pts;
 	fprintf(fp,"mesh2 {\nvertex_vectors {\n%d\n",p);
-	for(i=0;i<p;i++,ptsp+=3) fprintf(fp,",<%g,%g,%g>\n",x+*ptsp*0.5,y+ptsp[1]*0.5,z+ptsp[2]*0.5);
+	for(i=0;i<p;i++) fprintf(fp,",<%g,%g,%g>\n",x+pt(i,0)*0.5,y+pt(i,1)*0.5,z+pt(i,2)*0.5);
 	fprintf(fp,"}\nface_indices {\n%d\n",(p-2)<<1);
 	for(i=1;i<p;i++) for(j=0;j<nu[i];j++) {
 		k=ed[i][j];
@@ -1588,10 +1629,9 @@ inline void voronoicell_base::reset_edges() {
  * \return -1 if the point is inside the plane, 1 if the point is outside the
  *         plane, or 0 if the point is within the plane. */
 inline int voronoicell_base::m_test(int n,double &ans) {
-	double *pp=pts+n+(n<<1);
-	ans=*(pp++)*px;
-	ans+=*(pp++)*py;
-	ans+=*pp*pz-prsq;
+	ans=pt(n,0)*px;
+	ans+=pt(n,1)*py;
+	ans+=pt(n,2)*pz-prsq;
 	if(ans<-tolerance2) {
 		return -1;
 	} else if(ans>tolerance2) {
@@ -1663,18 +1703,18 @@ inline void voronoicell_base::normals_search(std::vector<double> &v,int i,int j,
 	double ux,uy,uz,vx,vy,vz,wx,wy,wz,wmag;
 	do {
 		m=ed[k][l];ed[k][l]=-1-m;
-		ux=pts[3*m]-pts[3*k];
-		uy=pts[3*m+1]-pts[3*k+1];
-		uz=pts[3*m+2]-pts[3*k+2];
+		ux=pt(m,0)-pt(k,0);
+		uy=pt(m,1)-pt(k,1);
+		uz=pt(m,2)-pt(k,2);
 
 		// Test to see if the length of this edge is above the tolerance
 		if(ux*ux+uy*uy+uz*uz>tolerance_sq) {
 			while(m!=i) {
 				l=cycle_up(ed[k][nu[k]+l],m);
 				k=m;m=ed[k][l];ed[k][l]=-1-m;
-				vx=pts[3*m]-pts[3*k];
-				vy=pts[3*m+1]-pts[3*k+1];
-				vz=pts[3*m+2]-pts[3*k+2];
+				vx=pt(m,0)-pt(k,0);
+				vy=pt(m,1)-pt(k,1);
+				vz=pt(m,2)-pt(k,2);
 
 				// Construct the vector product of this edge with
 				// the previous one
@@ -1759,11 +1799,10 @@ void voronoicell_base::output_vertex_orders(FILE *fp) {
  * \param[out] v the vector to store the results in. */
 void voronoicell_base::vertices(std::vector<double> &v) {
 	v.resize(3*p);
-	double *ptsp=pts;
-	for(int i=0;i<3*p;i+=3) {
-		v[i]=*(ptsp++)*0.5;
-		v[i+1]=*(ptsp++)*0.5;
-		v[i+2]=*(ptsp++)*0.5;
+	for(int i=0;i<p;i++) {
+		v[3*i]=pt(i,0)*0.5;
+		v[3*i+1]=pt(i,1)*0.5;
+		v[3*i+2]=pt(i,2)*0.5;
 	}
 }
 
@@ -1771,8 +1810,8 @@ void voronoicell_base::vertices(std::vector<double> &v) {
  * \param[out] fp the file handle to write to. */
 void voronoicell_base::output_vertices(FILE *fp) {
 	if(p>0) {
-		fprintf(fp,"(%g,%g,%g)",*pts*0.5,pts[1]*0.5,pts[2]*0.5);
-		for(double *ptsp=pts+3;ptsp<pts+3*p;ptsp+=3) fprintf(fp," (%g,%g,%g)",*ptsp*0.5,ptsp[1]*0.5,ptsp[2]*0.5);
+		fprintf(fp,"(%g,%g,%g)",pt(0,0)*0.5,pt(0,1)*0.5,pt(0,2)*0.5);
+		for(int i=1;i<p;i++) fprintf(fp," (%g,%g,%g)",pt(i,0)*0.5,pt(i,1)*0.5,pt(i,2)*0.5);
 	}
 }
 
@@ -1783,11 +1822,10 @@ void voronoicell_base::output_vertices(FILE *fp) {
  *                    coordinate system. */
 void voronoicell_base::vertices(double x,double y,double z,std::vector<double> &v) {
 	v.resize(3*p);
-	double *ptsp=pts;
-	for(int i=0;i<3*p;i+=3) {
-		v[i]=x+*(ptsp++)*0.5;
-		v[i+1]=y+*(ptsp++)*0.5;
-		v[i+2]=z+*(ptsp++)*0.5;
+	for(int i=0;i<p;i++) {
+		v[3*i]=x+pt(i,0)*0.5;
+		v[3*i+1]=y+pt(i,1)*0.5;
+		v[3*i+2]=z+pt(i,2)*0.5;
 	}
 }
 
@@ -1797,9 +1835,37 @@ void voronoicell_base::vertices(double x,double y,double z,std::vector<double> &
  *                    coordinate system. */
 void voronoicell_base::output_vertices(double x,double y,double z,FILE *fp) {
 	if(p>0) {
-		fprintf(fp,"(%g,%g,%g)",x+*pts*0.5,y+pts[1]*0.5,z+pts[2]*0.5);
-		for(double *ptsp=pts+3;ptsp<pts+3*p;ptsp+=3) fprintf(fp," (%g,%g,%g)",x+*ptsp*0.5,y+ptsp[1]*0.5,z+ptsp[2]*0.5);
+		fprintf(fp,"(%g,%g,%g)",x+pt(0,0)*0.5,y+pt(0,1)*0.5,z+pt(0,2)*0.5);
+		for(int i=1;i<p;i++) fprintf(fp," (%g,%g,%g)",x+pt(i,0)*0.5,y+pt(i,1)*0.5,z+pt(i,2)*0.5);
+	}
+}
+
+/** Writes the vertices, edge connections, neighboring particle IDs, and vertex
+ * planes of the cell into a cell_extract structure in one pass over the
+ * vertices. The arrays of the structure are resized without releasing their
+ * memory, so that reusing one structure for many cells avoids repeated
+ * allocation.
+ * \param[in] (x,y,z) the position vector of the particle in the global
+ *                    coordinate system.
+ * \param[out] e the structure to store the results in. */
+void voronoicell_base::extract(double x,double y,double z,cell_extract &e) {
+	int i,j,k=0;
+	e.n=p;
+	e.pts.resize(3*p);e.off.resize(p+1);
+	for(i=0;i<p;i++) k+=nu[i];
+	e.adj.resize(k);
+	double *pp=e.pts.empty()?NULL:&e.pts[0];
+	int *ap=e.adj.empty()?NULL:&e.adj[0];
+	for(k=i=0;i<p;i++) {
+		*(pp++)=x+pt(i,0)*0.5;
+		*(pp++)=y+pt(i,1)*0.5;
+		*(pp++)=z+pt(i,2)*0.5;
+		e.off[i]=k;
+		for(j=0;j<nu[i];j++) ap[k++]=ed[i][j];
 	}
+	e.off[p]=k;
+	neighbors(e.nbr);
+	vertex_planes(e.vpl);
 }
 
 /** This routine returns the perimeters of each face.
@@ -1811,17 +1877,17 @@ void voronoicell_base::face_perimeters(std::vector<double> &v) {
 	for(i=1;i<p;i++) for(j=0;j<nu[i];j++) {
 		k=ed[i][j];
 		if(k>=0) {
-			dx=pts[3*k]-pts[3*i];
-			dy=pts[3*k+1]-pts[3*i+1];
-			dz=pts[3*k+2]-pts[3*i+2];
+			dx=pt(k,0)-pt(i,0);
+			dy=pt(k,1)-pt(i,1);
+			dz=pt(k,2)-pt(i,2);
 			perim=sqrt(dx*dx+dy*dy+dz*dz);
 			ed[i][j]=-1-k;
 			l=cycle_up(ed[i][nu[i]+j],k);
 			do {
 				m=ed[k][l];
-				dx=pts[3*m]-pts[3*k];
-				dy=pts[3*m+1]-pts[3*k+1];
-				dz=pts[3*m+2]-pts[3*k+2];
+				dx=pt(m,0)-pt(k,0);
+				dy=pt(m,1)-pt(k,1);
+				dz=pt(m,2)-pt(k,2);
 				perim+=sqrt(dx*dx+dy*dy+dz*dz);
 				ed[k][l]=-1-m;
 				l=cycle_up(ed[k][nu[k]+l],m);
@@ -1918,7 +1984,7 @@ void voronoicell_base::face_freq_table(std::vector<int> &v) {
  * \param[in] rsq the distance along this vector of the plane.
  * \return False if the plane does not intersect the plane, true if it does. */
 bool voronoicell_base::plane_intersects(double x,double y,double z,double rsq) {
-	double g=x*pts[3*up]+y*pts[3*up+1]+z*pts[3*up+2];
+	double g=x*pt(up,0)+y*pt(up,1)+z*pt(up,2);
 	if(g<rsq) return plane_intersects_track(x,y,z,rsq,g);
 	return true;
 }
@@ -1932,12 +1998,12 @@ bool voronoicell_base::plane_intersects(double x,double y,double z,double rsq) {
  * \return False if the plane does not intersect the plane, true if it does. */
 bool voronoicell_base::plane_intersects_guess(double x,double y,double z,double rsq) {
 	up=0;
-	double g=x*pts[3*up]+y*pts[3*up+1]+z*pts[3*up+2];
+	double g=x*pt(up,0)+y*pt(up,1)+z*pt(up,2);
 	if(g<rsq) {
 		int ca=1,cc=p>>3,mp=1;
 		double m;
 		while(ca<cc) {
-			m=x*pts[3*mp]+y*pts[3*mp+1]+z*pts[3*mp+2];
+			m=x*pt(mp,0)+y*pt(mp,1)+z*pt(mp,2);
 			if(m>g) {
 				if(m>rsq) return true;
 				g=m;up=mp;
@@ -1963,7 +2029,7 @@ inline bool voronoicell_base::plane_intersects_track(double x,double y,double z,
 	// The test point is outside of the cutting space
 	for(us=0;us<nu[up];us++) {
 		tp=ed[up][us];
-		t=x*pts[3*tp]+y*pts[3*tp+1]+z*pts[3*tp+2];
+		t=x*pt(tp,0)+y*pt(tp,1)+z*pt(tp,2);
 		if(t>g) {
 			ls=ed[up][nu[up]+us];
 			up=tp;
@@ -1972,7 +2038,7 @@ inline bool voronoicell_base::plane_intersects_track(double x,double y,double z,
 #if VOROPP_VERBOSE >=1
 					fputs("Bailed out of convex calculation",stderr);
 #endif
-					for(tp=0;tp<p;tp++) if(x*pts[3*tp]+y*pts[3*tp+1]+z*pts[3*tp+2]>rsq) return true;
+					for(tp=0;tp<p;tp++) if(x*pt(tp,0)+y*pt(tp,1)+z*pt(tp,2)>rsq) return true;
 					return false;
 				}
 
@@ -1981,14 +2047,14 @@ inline bool voronoicell_base::plane_intersects_track(double x,double y,double z,
 				// plane
 				for(us=0;us<ls;us++) {
 					tp=ed[up][us];
-					g=x*pts[3*tp]+y*pts[3*tp+1]+z*pts[3*tp+2];
+					g=x*pt(tp,0)+y*pt(tp,1)+z*pt(tp,2);
 					if(g>t) break;
 				}
 				if(us==ls) {
 					us++;
 					while(us<nu[up]) {
 						tp=ed[up][us];
-						g=x*pts[3*tp]+y*pts[3*tp+1]+z*pts[3*tp+2];
+						g=x*pt(tp,0)+y*pt(tp,1)+z*pt(tp,2);
 						if(g>t) break;
 						us++;
 					}
@@ -2013,7 +2079,9 @@ int voronoicell_base::number_of_edges() {
 /** Outputs a custom string of information about the Voronoi cell. The string
  * of information follows a similar style as the C printf command, and detailed
  * information about its format is available at
- * http://math.lbl.gov/voro++/doc/custom.html.
+ * http://math.lbl.gov/voro++/doc/custom.html. The string is compiled by the
+ * custom_format class, which should be used directly when printing many
+ * cells, so that the string is only compiled once.
  * \param[in] format the custom string to print.
  * \param[in] i the ID of the particle associated with this Voronoi cell.
  * \param[in] (x,y,z) the position of the particle associated with this Voronoi
@@ -2021,78 +2089,8 @@ int voronoicell_base::number_of_edges() {
  * \param[in] r a radius associated with the particle.
  * \param[in] fp the file handle to write to. */
 void voronoicell_base::output_custom(const char *format,int i,double x,double y,double z,double r,FILE *fp) {
-	char *fmp=(const_cast<char*>(format));
-	std::vector<int> vi;
-	std::vector<double> vd;
-	while(*fmp!=0) {
-		if(*fmp=='%') {
-			fmp++;
-			switch(*fmp) {
-
-				// Particle-related output
-				case 'i': fprintf(fp,"%d",i);break;
-				case 'x': fprintf(fp,"%g",x);break;
-				case 'y': fprintf(fp,"%g",y);break;
-				case 'z': fprintf(fp,"%g",z);break;
-				case 'q': fprintf(fp,"%g %g %g",x,y,z);break;
-				case 'r': fprintf(fp,"%g",r);break;
-
-				// Vertex-related output
-				case 'w': fprintf(fp,"%d",p);break;
-				case 'p': output_vertices(fp);break;
-				case 'P': output_vertices(x,y,z,fp);break;
-				case 'o': output_vertex_orders(fp);break;
-				case 'm': fprintf(fp,"%g",0.25*max_radius_squared());break;
-
-				// Edge-related output
-				case 'g': fprintf(fp,"%d",number_of_edges());break;
-				case 'E': fprintf(fp,"%g",total_edge_distance());break;
-				case 'e': face_perimeters(vd);voro_print_vector(vd,fp);break;
-
-				// Face-related output
-				case 's': fprintf(fp,"%d",number_of_faces());break;
-				case 'F': fprintf(fp,"%g",surface_area());break;
-				case 'A': {
-						  face_freq_table(vi);
-						  voro_print_vector(vi,fp);
-					  } break;
-				case 'a': face_orders(vi);voro_print_vector(vi,fp);break;
-				case 'f': face_areas(vd);voro_print_vector(vd,fp);break;
-				case 't': {
-						  face_vertices(vi);
-						  voro_print_face_vertices(vi,fp);
-					  } break;
-				case 'l': normals(vd);
-					  voro_print_positions(vd,fp);
-					  break;
-				case 'n': neighbors(vi);
-					  voro_print_vector(vi,fp);
-					  break;
-
-				// Volume-related output
-				case 'v': fprintf(fp,"%g",volume());break;
-				case 'c': {
-						  double cx,cy,cz;
-						  centroid(cx,cy,cz);
-						  fprintf(fp,"%g %g %g",cx,cy,cz);
-					  } break;
-				case 'C': {
-						  double cx,cy,cz;
-						  centroid(cx,cy,cz);
-						  fprintf(fp,"%g %g %g",x+cx,y+cy,z+cz);
-					  } break;
-
-				// End-of-string reached
-				case 0: fmp--;break;
-
-				// The percent sign is not part of a
-				// control sequence
-				default: putc('%',fp);putc(*fmp,fp);
-			}
-		} else putc(*fmp,fp);
-		fmp++;
-	}
-	fputs("\n",fp);
+	custom_format cf(format);
+	cf.output(*this,i,x,y,z,r,fp);
 }
 
 /** This initializes the class to be a rectangular box. It calls the base class
@@ -2178,18 +2176,22 @@ void voronoicell_neighbor::check_facets() {
 
 /** The class constructor allocates memory for storing neighbor information. */
 voronoicell_neighbor::voronoicell_neighbor() {
-	int i;
+	int i,s=0;
 	mne=new int*[current_vertex_order];
 	ne=new int*[current_vertices];
-	for(i=0;i<3;i++) mne[i]=new int[init_n_vertices*i];
-	mne[3]=new int[init_3_vertices*3];
-	for(i=4;i<current_vertex_order;i++) mne[i]=new int[init_n_vertices*i];
+	for(i=0;i<current_vertex_order;i++) s+=mem[i]*i;
+	mne_pool=new int[s];
+	for(s=i=0;i<current_vertex_order;i++) {
+		mne[i]=mne_pool+s;
+		s+=mem[i]*i;
+	}
 }
 
 /** The class destructor frees the dynamically allocated memory for storing
  * neighbor information. */
 voronoicell_neighbor::~voronoicell_neighbor() {
-	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0) delete [] mne[i];
+	for(int i=current_vertex_order-1;i>=0;i--) if(mem[i]>0&&!pooled(i)) delete [] mne[i];
+	delete [] mne_pool;
 	delete [] mne;
 	delete [] ne;
 }
@@ -2215,19 +2217,28 @@ void voronoicell_neighbor::neighbors(std::vector<int> &v) {
 	reset_edges();
 }
 
+/** Computes a vector list of the planes at every vertex, taken from the
+ * neighbor information of the edges.
+ * \param[out] v the vector to store the results in. */
+void voronoicell_neighbor::vertex_planes(std::vector<int> &v) {
+	int i,j,k=0;
+	for(i=0;i<p;i++) k+=nu[i];
+	v.resize(k);
+	for(k=i=0;i<p;i++) for(j=0;j<nu[i];j++) v[k++]=ne[i][j];
+}
+
 /** Prints the vertices, their edges, the relation table, and also notifies if
  * any memory errors are visible. */
 void voronoicell_base::print_edges() {
 	int j;
-	double *ptsp=pts;
-	for(int i=0;i<p;i++,ptsp+=3) {
+	for(int i=0;i<p;i++) {
 		printf("%d %d  ",i,nu[i]);
 		for(j=0;j<nu[i];j++) printf(" %d",ed[i][j]);
 		printf("  ");
 		while(j<(nu[i]<<1)) printf(" %d",ed[i][j]);
 		printf("   %d",ed[i][j]);
 		print_edges_neighbors(i);
-		printf("  %g %g %g %p",*ptsp,ptsp[1],ptsp[2],(void*) ed[i]);
+		printf("  %g %g %g %p",pt(i,0),pt(i,1),pt(i,2),(void*) ed[i]);
 		if(ed[i]>=mep[nu[i]]+mec[nu[i]]*((nu[i]<<1)+1)) puts(" Memory error");
 		else puts("");
 	}
@@ -17,6 +17,48 @@
 
 namespace voro {
 
+/** \brief Flat buffers that receive the geometry of a Voronoi cell.
+ *
+ * This structure is filled by voronoicell_base::extract, which writes the
+ * vertices, the edge connections, and, for cells that track neighbor
+ * information, the neighboring particle IDs and the planes at every vertex of
+ * a cell in a single call. To extract only the vertex and edge graph, a
+ * voronoicell should be used, since it carries out none of the neighbor
+ * bookkeeping during the plane cuts. The arrays are cleared but not released
+ * between calls, so that once a structure is reused for several cells, no
+ * further memory allocation takes place. */
+struct cell_extract {
+	/** The number of vertices in the cell. */
+	int n;
+	/** The positions of the vertices, as 3*n consecutive (x,y,z)
+	 * triplets in the global coordinate system. */
+	std::vector<double> pts;
+	/** An array of n+1 offsets into the adj array, so that the vertices
+	 * connected to vertex i are held in adj[off[i]] to adj[off[i+1]-1].
+	 * The order of vertex i is off[i+1]-off[i]. */
+	std::vector<int> off;
+	/** The edge connections of all vertices, in the same order as in the
+	 * ed array of the cell. Every edge appears twice, once from each of
+	 * its ends. */
+	std::vector<int> adj;
+	/** The IDs of the neighboring particles, one per face, in the same
+	 * order as given by the neighbors routine. This is empty if the cell
+	 * does not track neighbor information. */
+	std::vector<int> nbr;
+	/** The IDs of the planes that produced every vertex, indexed in the
+	 * same way as the adj array, so that vpl[off[i]+j] is the ID of the
+	 * plane that made the face clockwise from the edge to adj[off[i]+j].
+	 * This is empty if the cell does not track neighbor information. */
+	std::vector<int> vpl;
+	cell_extract() : n(0) {}
+	/** Sets the structure to represent no cell, keeping the memory of
+	 * the arrays. */
+	inline void clear() {
+		n=0;pts.clear();off.assign(1,0);
+		adj.clear();nbr.clear();vpl.clear();
+	}
+};
+
 /** \brief A class representing a single Voronoi cell.
  *
  * This class represents a single Voronoi cell, as a collection of vertices
@@ -81,14 +123,29 @@ class voronoicell_base {
 		 * size held by current_vertices. */
 		int *nu;
 		/** This in an array with size 3*current_vertices for holding
-		 * the positions of the vertices. */
+		 * the positions of the vertices. By default the coordinates
+		 * of each vertex are stored together, as (x,y,z) triplets. If
+		 * VOROPP_SOA is set to 1, then the array instead holds three
+		 * 32-byte aligned blocks of current_vertices entries for the
+		 * x, y, and z coordinates. Either way, the pt() routine gives
+		 * access to a coordinate. */
 		double *pts;
+		/** Returns a reference to a coordinate of a vertex.
+		 * \param[in] i the vertex to consider.
+		 * \param[in] k the coordinate, 0 for x, 1 for y, or 2 for z.
+		 * \return A reference to the coordinate in the pts array. */
+#if VOROPP_SOA==1
+		inline double &pt(int i,int k) {return pts[k*current_vertices+i];}
+#else
+		inline double &pt(int i,int k) {return pts[3*i+k];}
+#endif
 		voronoicell_base();
 		~voronoicell_base();
 		void init_base(double xmin,double xmax,double ymin,double ymax,double zmin,double zmax);
 		void init_octahedron_base(double l);
 		void init_tetrahedron_base(double x0,double y0,double z0,double x1,double y1,double z1,double x2,double y2,double z2,double x3,double y3,double z3);
 		void translate(double x,double y,double z);
+		void reset();
 		void draw_pov(double x,double y,double z,FILE *fp=stdout);
 		/** Outputs the cell in POV-Ray format, using cylinders for edges
 		 * and spheres for vertices, to a given file.
@@ -134,6 +191,7 @@ class voronoicell_base {
 		void output_vertices(FILE *fp=stdout);
 		void vertices(double x,double y,double z,std::vector<double> &v);
 		void output_vertices(double x,double y,double z,FILE *fp=stdout);
+		void extract(double x,double y,double z,cell_extract &e);
 		void face_areas(std::vector<double> &v);
 		/** Outputs the areas of the faces.
 		 * \param[in] fp the file handle to write to. */
@@ -195,6 +253,12 @@ class voronoicell_base {
 		 *               results. If no neighbor information is
 		 *               available, a blank vector is returned. */
 		virtual void neighbors(std::vector<int> &v) {v.clear();}
+		/** Returns the IDs of the planes that produced every vertex,
+		 * one for every edge of the vertex, in the order of the edges.
+		 * \param[out] v a reference to a vector in which to return the
+		 *               results. If no neighbor information is
+		 *               available, a blank vector is returned. */
+		virtual void vertex_planes(std::vector<int> &v) {v.clear();}
 		/** This is a virtual function that is overridden by a routine
 		 * to print a list of IDs of neighboring particles
 		 * corresponding to each face. By default, when no neighbor
@@ -235,11 +299,24 @@ class voronoicell_base {
 		 * on mep[p] is stored in mem[p]. If the space runs out, the
 		 * code allocates more using the add_memory() routine. */
 		int **mep;
+		/** Returns the initial number of vertices that can be stored
+		 * for a given order.
+		 * \param[in] i the order to consider. */
+		inline int init_mem(int i) {return i==3?init_3_vertices:init_n_vertices;}
+		/** Tests whether the memory for a given order is still the
+		 * initial allocation, which is carved out of a single block
+		 * shared by all orders, rather than being allocated
+		 * separately.
+		 * \param[in] i the order to consider. */
+		inline bool pooled(int i) {return i<init_vertex_order&&mem[i]==init_mem(i);}
 		inline void reset_edges();
 		template<class vc_class>
 		void check_memory_for_copy(vc_class &vc,voronoicell_base* vb);
 		void copy(voronoicell_base* vb);
 	private:
+		/** The single block holding the initial mep arrays of all
+		 * orders. */
+		int *mep_pool;
 		/** This is the delete stack, used to store the vertices which
 		 * are going to be deleted during the plane cutting procedure.
 		 */
@@ -386,7 +463,7 @@ class voronoicell : public voronoicell_base {
 		inline void n_set_to_aux1(int j) {};
 		inline void n_set_to_aux2(int j) {};
 		inline void n_allocate_aux1(int i) {};
-		inline void n_switch_to_aux1(int i) {};
+		inline void n_switch_to_aux1(int i,bool pl) {};
 		inline void n_copy_to_aux1(int i,int m) {};
 		inline void n_set_to_aux1_offset(int k,int m) {};
 		inline void n_neighbors(std::vector<int> &v) {v.clear();};
@@ -468,12 +545,16 @@ class voronoicell_neighbor : public voronoicell_base {
 		void init_tetrahedron(double x0,double y0,double z0,double x1,double y1,double z1,double x2,double y2,double z2,double x3,double y3,double z3);
 		void check_facets();
 		virtual void neighbors(std::vector<int> &v);
+		virtual void vertex_planes(std::vector<int> &v);
 		virtual void print_edges_neighbors(int i);
 		virtual void output_neighbors(FILE *fp=stdout) {
 			std::vector<int> v;neighbors(v);
 			voro_print_vector(v,fp);
 		}
 	private:
+		/** The single block holding the initial mne arrays of all
+		 * orders. */
+		int *mne_pool;
 		int *paux1;
 		int *paux2;
 		inline void n_allocate(int i,int m) {mne[i]=new int[m*i];}
@@ -503,7 +584,7 @@ class voronoicell_neighbor : public voronoicell_base {
 		inline void n_set_to_aux1(int j) {ne[j]=paux1;}
 		inline void n_set_to_aux2(int j) {ne[j]=paux2;}
 		inline void n_allocate_aux1(int i) {paux1=new int[i*mem[i]];}
-		inline void n_switch_to_aux1(int i) {delete [] mne[i];mne[i]=paux1;}
+		inline void n_switch_to_aux1(int i,bool pl) {if(!pl) delete [] mne[i];mne[i]=paux1;}
 		inline void n_copy_to_aux1(int i,int m) {paux1[m]=mne[i][m];}
 		inline void n_set_to_aux1_offset(int k,int m) {ne[k]=paux1+m;}
 		friend class voronoicell_base;
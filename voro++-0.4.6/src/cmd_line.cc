@@ -8,6 +8,7 @@
  * \brief Source code for the command-line utility. */
 
 #include <cstring>
+#include <vector>
 
 #include "voro++.hh"
 using namespace voro;
@@ -29,7 +30,8 @@ void help_message() {
 	     "               <y_max> <z_min> <z_max> <filename>\n\n"
 	     "By default, the utility reads in the input file of particle IDs and positions,\n"
 	     "computes the Voronoi cell for each, and then creates <filename.vol> with an\n"
-	     "additional column containing the volume of each Voronoi cell.\n\n"
+	     "additional column containing the volume of each Voronoi cell. The input file\n"
+	     "may also be in the binary particle format, which is detected automatically.\n\n"
 	     "Available options:\n"
 	     " -c <str>   : Specify a custom output string\n"
 	     " -g         : Turn on the gnuplot output to <filename.gnu>\n"
@@ -47,6 +49,9 @@ void help_message() {
 	     " -py        : Make container periodic in the y direction\n"
 	     " -pz        : Make container periodic in the z direction\n"
 	     " -r         : Assume the input file has an extra coordinate for radii\n"
+	     " -t <n>     : Read the input file and compute the cells on n threads, or on\n"
+	     "              the default number of threads if n is zero (the cells are\n"
+	     "              computed on one thread with -o)\n"
 	     " -v         : Verbose output\n"
 	     " --version  : Print version information\n"
 	     " -wb [6]    : Add six plane wall objects to make rectangular box containing\n"
@@ -120,51 +125,110 @@ void error_message() {
 	fputs("voro++: Unrecognized command-line options; type \"voro++ -h\" for more\ninformation.\n",stderr);
 }
 
+// Writes the output for a single computed Voronoi cell to the requested files
+template<class v_cell,class c_loop>
+inline void cmd_line_cell_output(v_cell &c,c_loop &vl,int ps,custom_format &cf,FILE* outfile,FILE* gnu_file,FILE* povp_file,FILE* povv_file) {
+	int pid;double x,y,z,r;
+	vl.pos(pid,x,y,z,r);
+	if(outfile!=NULL) cf.output(c,pid,x,y,z,r,outfile);
+	if(gnu_file!=NULL) c.draw_gnuplot(x,y,z,gnu_file);
+	if(povp_file!=NULL) {
+		fprintf(povp_file,"// id %d\n",pid);
+		if(ps==4) fprintf(povp_file,"sphere{<%g,%g,%g>,%g}\n",x,y,z,r);
+		else fprintf(povp_file,"sphere{<%g,%g,%g>,s}\n",x,y,z);
+	}
+	if(povv_file!=NULL) {
+		fprintf(povv_file,"// cell %d\n",pid);
+		c.draw_pov(x,y,z,povv_file);
+	}
+}
+
 // Carries out the Voronoi computation and outputs the results to the requested
 // files
 template<class c_loop,class c_class>
 void cmd_line_output(c_loop &vl,c_class &con,const char* format,FILE* outfile,FILE* gnu_file,FILE* povp_file,FILE* povv_file,bool verbose,double &vol,int &vcc,int &tp) {
-	int pid,ps=con.ps;double x,y,z,r;
+	int ps=con.ps;
+	custom_format cf(format);
 	if(con.contains_neighbor(format)) {
 		voronoicell_neighbor c;
 		if(vl.start()) do if(con.compute_cell(c,vl)) {
-			vl.pos(pid,x,y,z,r);
-			if(outfile!=NULL) c.output_custom(format,pid,x,y,z,r,outfile);
-			if(gnu_file!=NULL) c.draw_gnuplot(x,y,z,gnu_file);
-			if(povp_file!=NULL) {
-				fprintf(povp_file,"// id %d\n",pid);
-				if(ps==4) fprintf(povp_file,"sphere{<%g,%g,%g>,%g}\n",x,y,z,r);
-				else fprintf(povp_file,"sphere{<%g,%g,%g>,s}\n",x,y,z);
-			}
-			if(povv_file!=NULL) {
-				fprintf(povv_file,"// cell %d\n",pid);
-				c.draw_pov(x,y,z,povv_file);
-			}
+			cmd_line_cell_output(c,vl,ps,cf,outfile,gnu_file,povp_file,povv_file);
 			if(verbose) {vol+=c.volume();vcc++;}
 		} while(vl.inc());
 	} else {
 		voronoicell c;
 		if(vl.start()) do if(con.compute_cell(c,vl)) {
-			vl.pos(pid,x,y,z,r);
-			if(outfile!=NULL) c.output_custom(format,pid,x,y,z,r,outfile);
-			if(gnu_file!=NULL) c.draw_gnuplot(x,y,z,gnu_file);
-			if(povp_file!=NULL) {
-				fprintf(povp_file,"// id %d\n",pid);
-				if(ps==4) fprintf(povp_file,"sphere{<%g,%g,%g>,%g}\n",x,y,z,r);
-				else fprintf(povp_file,"sphere{<%g,%g,%g>,s}\n",x,y,z);
-			}
-			if(povv_file!=NULL) {
-				fprintf(povv_file,"// cell %d\n",pid);
-				c.draw_pov(x,y,z,povv_file);
-			}
+			cmd_line_cell_output(c,vl,ps,cf,outfile,gnu_file,povp_file,povv_file);
 			if(verbose) {vol+=c.volume();vcc++;}
 		} while(vl.inc());
 	}
 	if(verbose) tp=con.total_particles();
 }
 
+// A function object for compute_cells_parallel that writes the output of each
+// thread to its own temporary files, which are then appended to the requested
+// files in thread order. Since each thread handles a contiguous range of the
+// loop, the result is the same as the serial output. Every thread has its own
+// compiled custom format, which buffers the custom output.
+struct cmd_line_parallel {
+	const char* format;
+	int ps;
+	bool verbose;
+	FILE *files[4];
+	std::vector<FILE*> tfiles;
+	std::vector<custom_format*> cfs;
+	std::vector<double> vols;
+	std::vector<char> done;
+	cmd_line_parallel(const char* format_,int ps_,bool verbose_,FILE* outfile,FILE* gnu_file,FILE* povp_file,FILE* povv_file)
+		: format(format_), ps(ps_), verbose(verbose_) {
+		files[0]=outfile;files[1]=gnu_file;files[2]=povp_file;files[3]=povv_file;
+	}
+	void init(int n,int nt) {
+		tfiles.assign(4*nt,(FILE*) NULL);
+		cfs.resize(nt);
+		for(int t=0;t<nt;t++) cfs[t]=new custom_format(format);
+		for(int t=0;t<nt;t++) for(int l=0;l<4;l++) if(files[l]!=NULL) {
+			tfiles[4*t+l]=tmpfile();
+			if(tfiles[4*t+l]==NULL) voro_fatal_error("Unable to open temporary file",VOROPP_FILE_ERROR);
+		}
+		if(verbose) {vols.assign(n,0);done.assign(n,0);}
+	}
+	template<class v_cell,class c_loop>
+	inline void operator()(int t,int m,bool computed,v_cell &c,c_loop &vl) {
+		if(!computed) return;
+		FILE **tf=&tfiles[4*t];
+		cmd_line_cell_output(c,vl,ps,*cfs[t],tf[0],tf[1],tf[2],tf[3]);
+		if(verbose) {vols[m]=c.volume();done[m]=1;}
+	}
+	// Flushes the custom output of every thread, appends the temporary
+	// files to the output files and closes them, and sums the cell volumes
+	// in loop order
+	void finish(double &vol,int &vcc) {
+		char buf[65536];size_t k;
+		for(unsigned int t=0;t<cfs.size();t++) delete cfs[t];
+		for(unsigned int l=0;l<tfiles.size();l++) if(tfiles[l]!=NULL) {
+			rewind(tfiles[l]);
+			while((k=fread(buf,1,sizeof(buf),tfiles[l]))>0) fwrite(buf,1,k,files[l&3]);
+			fclose(tfiles[l]);
+		}
+		for(unsigned int m=0;m<done.size();m++) if(done[m]) {vol+=vols[m];vcc++;}
+	}
+};
+
+// Carries out the Voronoi computation on several threads and outputs the
+// results to the requested files
+template<class c_class>
+void cmd_line_output_parallel(c_class &con,int threads,const char* format,FILE* outfile,FILE* gnu_file,FILE* povp_file,FILE* povv_file,bool verbose,double &vol,int &vcc,int &tp) {
+	c_loop_all vl(con);
+	cmd_line_parallel f(format,con.ps,verbose,outfile,gnu_file,povp_file,povv_file);
+	if(con.contains_neighbor(format)) con.template compute_cells<voronoicell_neighbor>(vl,f,threads);
+	else con.template compute_cells<voronoicell>(vl,f,threads);
+	f.finish(vol,vcc);
+	if(verbose) tp=con.total_particles();
+}
+
 int main(int argc,char **argv) {
-	int i=1,j=-7,custom_output=0,nx,ny,nz,init_mem(8);
+	int i=1,j=-7,custom_output=0,nx,ny,nz,init_mem(8),threads(1);
 	double ls=0;
 	blocks_mode bm=none;
 	bool gnuplot_output=false,povp_output=false,povv_output=false,polydisperse=false;
@@ -253,6 +317,9 @@ int main(int argc,char **argv) {
 			zperiodic=true;
 		} else if(strcmp(argv[i],"-r")==0) {
 			polydisperse=true;
+		} else if(strcmp(argv[i],"-t")==0) {
+			if(i>=argc-8) {error_message();wl.deallocate();return VOROPP_CMD_LINE_ERROR;}
+			i++;threads=atoi(argv[i]);
 		} else if(strcmp(argv[i],"-v")==0) {
 			verbose=true;
 		} else if(strcmp(argv[i],"--version")==0) {
@@ -317,6 +384,13 @@ int main(int argc,char **argv) {
 		i++;
 	}
 
+	// Check the thread count is not negative
+	if(threads<0) {
+		fputs("voro++: The number of threads must not be negative\n",stderr);
+		wl.deallocate();
+		return VOROPP_CMD_LINE_ERROR;
+	}
+
 	// Check the memory guess is positive
 	if(init_mem<=0) {
 		fputs("voro++: The memory allocation must be positive\n",stderr);
@@ -351,11 +425,11 @@ int main(int argc,char **argv) {
 	if(bm==none) {
 		if(polydisperse) {
 			pconp=new pre_container_poly(ax,bx,ay,by,az,bz,xperiodic,yperiodic,zperiodic);
-			pconp->import(argv[i+6]);
+			pconp->import_bulk(argv[i+6],threads);
 			pconp->guess_optimal(nx,ny,nz);
 		} else {
 			pcon=new pre_container(ax,bx,ay,by,az,bz,xperiodic,yperiodic,zperiodic);
-			pcon->import(argv[i+6]);
+			pcon->import_bulk(argv[i+6],threads);
 			pcon->guess_optimal(nx,ny,nz);
 		}
 	} else {
@@ -435,7 +509,11 @@ int main(int argc,char **argv) {
 			con.add_wall(wl);
 			if(bm==none) {
 				pconp->setup(vo,con);delete pconp;
-			} else con.import(vo,argv[i+6]);
+			} else {
+				pre_container_poly pc(ax,bx,ay,by,az,bz,xperiodic,yperiodic,zperiodic);
+				pc.import_bulk(argv[i+6],threads);
+				pc.setup(vo,con);
+			}
 
 			c_loop_order vlo(con,vo);
 			cmd_line_output(vlo,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
@@ -445,10 +523,13 @@ int main(int argc,char **argv) {
 
 			if(bm==none) {
 				pconp->setup(con);delete pconp;
-			} else con.import(argv[i+6]);
+			} else con.import_bulk(argv[i+6],threads);
 
-			c_loop_all vla(con);
-			cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			if(threads!=1) cmd_line_output_parallel(con,threads,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			else {
+				c_loop_all vla(con);
+				cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			}
 		}
 	} else {
 		if(ordered) {
@@ -457,7 +538,11 @@ int main(int argc,char **argv) {
 			con.add_wall(wl);
 			if(bm==none) {
 				pcon->setup(vo,con);delete pcon;
-			} else con.import(vo,argv[i+6]);
+			} else {
+				pre_container pc(ax,bx,ay,by,az,bz,xperiodic,yperiodic,zperiodic);
+				pc.import_bulk(argv[i+6],threads);
+				pc.setup(vo,con);
+			}
 
 			c_loop_order vlo(con,vo);
 			cmd_line_output(vlo,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
@@ -466,9 +551,12 @@ int main(int argc,char **argv) {
 			con.add_wall(wl);
 			if(bm==none) {
 				pcon->setup(con);delete pcon;
-			} else con.import(argv[i+6]);
-			c_loop_all vla(con);
-			cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			} else con.import_bulk(argv[i+6],threads);
+			if(threads!=1) cmd_line_output_parallel(con,threads,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			else {
+				c_loop_all vla(con);
+				cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			}
 		}
 	}
 
@@ -104,6 +104,24 @@ const double optimal_particles=5.6;
  * put outside of the container geometry. */
 #define VOROPP_REPORT_OUT_OF_BOUNDS 0
 
+/** If this is set to 1, then the voronoicell classes store the vertex
+ * positions as separate, aligned arrays of x, y, and z coordinates, rather
+ * than as (x,y,z) triplets. See the description of voronoicell_base::pts. */
+#ifndef VOROPP_SOA
+#define VOROPP_SOA 0
+#endif
+
+/** If this is set to 1, then binary particle files are memory mapped when they
+ * are imported. Otherwise they are read into memory in one piece. Memory
+ * mapping is only available on POSIX systems. */
+#ifndef VOROPP_MMAP
+#if defined(__unix__)||defined(__APPLE__)
+#define VOROPP_MMAP 1
+#else
+#define VOROPP_MMAP 0
+#endif
+#endif
+
 /** Voro++ returns this status code if there is a file-related error, such as
  * not being able to open file. */
 #define VOROPP_FILE_ERROR 1
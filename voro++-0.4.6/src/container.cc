@@ -7,7 +7,10 @@
 /** \file container.cc
  * \brief Function implementations for the container and related classes. */
 
+#include <algorithm>
+
 #include "container.hh"
+#include "p_import.hh"
 
 namespace voro {
 
@@ -32,19 +35,21 @@ container_base::container_base(double ax_,double bx_,double ay_,double by_,doubl
 	: voro_base(nx_,ny_,nz_,(bx_-ax_)/nx_,(by_-ay_)/ny_,(bz_-az_)/nz_),
 	ax(ax_), bx(bx_), ay(ay_), by(by_), az(az_), bz(bz_),
 	xperiodic(xperiodic_), yperiodic(yperiodic_), zperiodic(zperiodic_),
-	id(new int*[nxyz]), p(new double*[nxyz]), co(new int[nxyz]), mem(new int[nxyz]), ps(ps_) {
+	id(new int*[nxyz]), p(new double*[nxyz]), co(new int[nxyz]), mem(new int[nxyz]), ps(ps_),
+	id_arena(new int[(size_t) nxyz*init_mem]), p_arena(new double[(size_t) ps*nxyz*init_mem]),
+	arena_mem((size_t) nxyz*init_mem) {
 	int l;
 	for(l=0;l<nxyz;l++) co[l]=0;
 	for(l=0;l<nxyz;l++) mem[l]=init_mem;
-	for(l=0;l<nxyz;l++) id[l]=new int[init_mem];
-	for(l=0;l<nxyz;l++) p[l]=new double[ps*init_mem];
+	for(l=0;l<nxyz;l++) id[l]=id_arena+(size_t) l*init_mem;
+	for(l=0;l<nxyz;l++) p[l]=p_arena+(size_t) ps*l*init_mem;
 }
 
 /** The container destructor frees the dynamically allocated memory. */
 container_base::~container_base() {
-	int l;
-	for(l=0;l<nxyz;l++) delete [] p[l];
-	for(l=0;l<nxyz;l++) delete [] id[l];
+	for(int l=0;l<nxyz;l++) release_block(l);
+	delete [] p_arena;
+	delete [] id_arena;
 	delete [] id;
 	delete [] p;
 	delete [] co;
@@ -107,6 +112,62 @@ void container_poly::put(int n,double x,double y,double z,double r) {
 	}
 }
 
+/** Puts an array of particles into the container. The particles are first
+ * counted per region, so that the memory of every region is allocated at most
+ * once, and they are then copied into place on several threads. The particles
+ * are stored in the same order as with successive calls to put.
+ * \param[in] ids the numerical IDs of the inserted particles.
+ * \param[in] (xs,ys,zs) the position vectors of the inserted particles.
+ * \param[in] n the number of particles.
+ * \param[in] threads the number of threads to copy the particles on, or zero
+ *                    for the OpenMP default. */
+void container::put_all(const int *ids,const double *xs,const double *ys,const double *zs,int n,int threads) {
+	int *sl=new int[n];
+	put_all_locate(xs,ys,zs,n,sl);
+	int nt=threads>0?threads:1;
+#ifdef _OPENMP
+	if(threads<=0) nt=omp_get_max_threads();
+#endif
+#pragma omp parallel for num_threads(nt)
+	for(int l=0;l<n;l++) if(sl[l]>=0) {
+		int ijk;double x=xs[l],y=ys[l],z=zs[l];
+		put_remap(ijk,x,y,z);
+		id[ijk][sl[l]]=ids[l];
+		double *pp=p[ijk]+3*sl[l];
+		*(pp++)=x;*(pp++)=y;*pp=z;
+	}
+	delete [] sl;
+}
+
+/** Puts an array of particles into the container. The particles are first
+ * counted per region, so that the memory of every region is allocated at most
+ * once, and they are then copied into place on several threads. The particles
+ * are stored in the same order as with successive calls to put.
+ * \param[in] ids the numerical IDs of the inserted particles.
+ * \param[in] (xs,ys,zs) the position vectors of the inserted particles.
+ * \param[in] rs the radii of the inserted particles.
+ * \param[in] n the number of particles.
+ * \param[in] threads the number of threads to copy the particles on, or zero
+ *                    for the OpenMP default. */
+void container_poly::put_all(const int *ids,const double *xs,const double *ys,const double *zs,const double *rs,int n,int threads) {
+	int *sl=new int[n];
+	put_all_locate(xs,ys,zs,n,sl);
+	int nt=threads>0?threads:1;
+#ifdef _OPENMP
+	if(threads<=0) nt=omp_get_max_threads();
+#endif
+#pragma omp parallel for num_threads(nt)
+	for(int l=0;l<n;l++) if(sl[l]>=0) {
+		int ijk;double x=xs[l],y=ys[l],z=zs[l];
+		put_remap(ijk,x,y,z);
+		id[ijk][sl[l]]=ids[l];
+		double *pp=p[ijk]+4*sl[l];
+		*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=rs[l];
+	}
+	for(int l=0;l<n;l++) if(sl[l]>=0&&max_radius<rs[l]) max_radius=rs[l];
+	delete [] sl;
+}
+
 /** Put a particle into the correct region of the container, also recording
  * into which region it was stored.
  * \param[in] vo the ordering class in which to record the region.
@@ -159,6 +220,45 @@ bool container_base::put_locate_block(int &ijk,double &x,double &y,double &z) {
 	return false;
 }
 
+/** Prepares an array of particles for insertion into the container. The
+ * particles are counted per region in input order, which assigns every
+ * particle its slot within its region. If any region would overflow, then
+ * the arena is rebuilt, with every region that would overflow enlarged to
+ * exactly the required size, so that the regions stay contiguous. On exit, the
+ * particle counts of the regions already include the new particles.
+ * \param[in] (xs,ys,zs) the position vectors of the particles.
+ * \param[in] n the number of particles.
+ * \param[out] sl the slot of every particle within its region, or -1 if it
+ *                lies outside the container. */
+void container_base::put_all_locate(const double *xs,const double *ys,const double *zs,int n,int *sl) {
+	int l,ijk,*cnt=new int[nxyz];
+	double x,y,z;
+
+	// Assign the slots, counting on top of the existing particles
+	for(l=0;l<nxyz;l++) cnt[l]=co[l];
+	for(l=0;l<n;l++) {
+		x=xs[l];y=ys[l];z=zs[l];
+		if(put_remap(ijk,x,y,z)) sl[l]=cnt[ijk]++;
+		else {
+			sl[l]=-1;
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+			fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",xs[l],ys[l],zs[l]);
+#endif
+		}
+	}
+	// If any region overflows, then rebuild the arena with room for the
+	// new particles
+	for(l=0;l<nxyz;l++) if(cnt[l]>mem[l]) break;
+	if(l<nxyz) {
+		int *nm=new int[nxyz];
+		for(l=0;l<nxyz;l++) nm[l]=cnt[l]>mem[l]?cnt[l]:mem[l];
+		set_arena(nm);
+		delete [] nm;
+	}
+	for(l=0;l<nxyz;l++) co[l]=cnt[l];
+	delete [] cnt;
+}
+
 /** Takes a particle position vector and computes the region index into which
  * it should be stored. If the container is periodic, then the routine also
  * maps the particle position to ensure it is in the primary domain. If the
@@ -220,6 +320,82 @@ inline bool container_base::remap(int &ai,int &aj,int &ak,int &ci,int &cj,int &c
 	return true;
 }
 
+/** Takes an array of vectors and finds the particles whose Voronoi cells
+ * contain them, giving the same results as calling find_voronoi_cell for each
+ * vector. The vectors are first sorted by the block that they are in, and the
+ * sorted list is split into one contiguous range per thread, each with its own
+ * voro_compute class. When consecutive vectors fall into the same block, the
+ * search for the second one starts from the distance to the particle found
+ * for the first, which is usually close to the answer and lets most distant
+ * blocks be skipped. Only when two particles are exactly equally close can the
+ * choice between them differ from the single vector routine.
+ * \param[in] con a reference to the derived container class.
+ * \param[in] (hx,hy,hz) the size of the search mask, as used by the container.
+ * \param[in] (xs,ys,zs) the vectors to test.
+ * \param[in] n the number of vectors.
+ * \param[out] pids the IDs of the particles, or -1 for a vector that lies
+ *		  outside the container or if the container is empty.
+ * \param[out] imgs the periodic images of the particles, as 3*n integers.
+ *		  Entries 3*l to 3*l+2 hold the number of domain lengths in
+ *		  the x, y, and z directions by which particle pids[l] is
+ *		  displaced from its stored position.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+template<class c_class>
+void container_base::find_voronoi_cells(c_class &con,int hx,int hy,int hz,const double *xs,const double *ys,const double *zs,int n,int *pids,int *imgs,int threads) {
+	int l,ai,aj,ak,ci,cj,ck,ijk,*bl=new int[n],*ord=new int[n],*cnt=new int[nxyz+1];
+	double x,y,z;
+
+	// Sort the vectors by block with a counting sort, which keeps the
+	// input order within each block
+	for(l=0;l<=nxyz;l++) cnt[l]=0;
+	for(l=0;l<n;l++) {
+		x=xs[l];y=ys[l];z=zs[l];
+		if(remap(ai,aj,ak,ci,cj,ck,x,y,z,ijk)) {bl[l]=ijk;cnt[ijk+1]++;}
+		else {bl[l]=-1;pids[l]=-1;imgs[3*l]=imgs[3*l+1]=imgs[3*l+2]=0;}
+	}
+	for(l=0;l<nxyz;l++) cnt[l+1]+=cnt[l];
+	int m=cnt[nxyz];
+	for(l=0;l<n;l++) if(bl[l]>=0) ord[cnt[bl[l]]++]=l;
+
+	int nt=threads>0?threads:1;
+#ifdef _OPENMP
+	if(threads<=0) nt=omp_get_max_threads();
+#endif
+#pragma omp parallel num_threads(nt)
+	{
+		int t=0,tn=1,l,ai,aj,ak,ci,cj,ck,ijk;
+#ifdef _OPENMP
+		t=omp_get_thread_num();tn=omp_get_num_threads();
+#endif
+		voro_compute<c_class> vc(con,hx,hy,hz);
+		particle_record w;
+		double x,y,z,mrs;
+		int s,se=(int) ((long) m*(t+1)/tn),pb=-1;
+		for(s=(int) ((long) m*t/tn);s<se;s++) {
+			l=ord[s];
+			x=xs[l];y=ys[l];z=zs[l];
+			if(!remap(ai,aj,ak,ci,cj,ck,x,y,z,ijk)) continue;
+
+			// Seed the search with the particle found for the
+			// previous vector, if it was in the same block
+			vc.find_voronoi_cell(x,y,z,ci,cj,ck,ijk,w,mrs,ijk==pb&&w.ijk!=-1);
+			pb=ijk;
+
+			if(w.ijk!=-1) {
+				if(xperiodic) {ci+=w.di;if(ci<0||ci>=nx) ai+=step_div(ci,nx);}
+				if(yperiodic) {cj+=w.dj;if(cj<0||cj>=ny) aj+=step_div(cj,ny);}
+				if(zperiodic) {ck+=w.dk;if(ck<0||ck>=nz) ak+=step_div(ck,nz);}
+				pids[l]=id[w.ijk][w.l];
+			} else {pids[l]=-1;ai=aj=ak=0;}
+			imgs[3*l]=ai;imgs[3*l+1]=aj;imgs[3*l+2]=ak;
+		}
+	}
+	delete [] cnt;
+	delete [] ord;
+	delete [] bl;
+}
+
 /** Takes a vector and finds the particle whose Voronoi cell contains that
  * vector. This is equivalent to finding the particle which is nearest to the
  * vector. Additional wall classes are not considered by this routine.
@@ -259,6 +435,19 @@ bool container::find_voronoi_cell(double x,double y,double z,double &rx,double &
 	return false;
 }
 
+/** Takes an array of vectors and finds the particles whose Voronoi cells
+ * contain them, using the find_voronoi_cells routine of the base class.
+ * \param[in] (xs,ys,zs) the vectors to test.
+ * \param[in] n the number of vectors.
+ * \param[out] pids the IDs of the particles, or -1 for a vector that could not
+ *		  be located.
+ * \param[out] imgs the periodic images of the particles, as 3*n integers.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+void container::find_voronoi_cells(const double *xs,const double *ys,const double *zs,int n,int *pids,int *imgs,int threads) {
+	container_base::find_voronoi_cells(*this,vc.hx,vc.hy,vc.hz,xs,ys,zs,n,pids,imgs,threads);
+}
+
 /** Takes a vector and finds the particle whose Voronoi cell contains that
  * vector. Additional wall classes are not considered by this routine.
  * \param[in] (x,y,z) the vector to test.
@@ -297,10 +486,32 @@ bool container_poly::find_voronoi_cell(double x,double y,double z,double &rx,dou
 	return false;
 }
 
+/** Takes an array of vectors and finds the particles whose Voronoi cells
+ * contain them, using the find_voronoi_cells routine of the base class. For
+ * the radical tessellation, this minimizes the weighted distance.
+ * \param[in] (xs,ys,zs) the vectors to test.
+ * \param[in] n the number of vectors.
+ * \param[out] pids the IDs of the particles, or -1 for a vector that could not
+ *		  be located.
+ * \param[out] imgs the periodic images of the particles, as 3*n integers.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+void container_poly::find_voronoi_cells(const double *xs,const double *ys,const double *zs,int n,int *pids,int *imgs,int threads) {
+	container_base::find_voronoi_cells(*this,vc.hx,vc.hy,vc.hz,xs,ys,zs,n,pids,imgs,threads);
+}
+
 /** Increase memory for a particular region.
  * \param[in] i the index of the region to reallocate. */
 void container_base::add_particle_memory(int i) {
-	int l,nmem=mem[i]<<1;
+	set_particle_memory(i,mem[i]<<1);
+}
+
+/** Sets the memory for a particular region to a given size, keeping the
+ * particles that it currently holds.
+ * \param[in] i the index of the region to reallocate.
+ * \param[in] nmem the new number of particles that the region can hold. */
+void container_base::set_particle_memory(int i,int nmem) {
+	int l;
 
 	// Carry out a check on the memory allocation size, and
 	// print a status message if requested
@@ -316,10 +527,58 @@ void container_base::add_particle_memory(int i) {
 	double *pp=new double[ps*nmem];
 	for(l=0;l<ps*co[i];l++) pp[l]=p[i][l];
 
-	// Update pointers and delete old arrays
+	// Update pointers and delete old arrays, unless they are part of
+	// the arena
 	mem[i]=nmem;
-	delete [] id[i];id[i]=idp;
-	delete [] p[i];p[i]=pp;
+	release_block(i);
+	id[i]=idp;p[i]=pp;
+}
+
+/** Allocates a new arena holding the particles of all regions, with the
+ * regions stored one after another in order, and moves the particles into it.
+ * Regions that had been allocated separately are freed, as is the old arena.
+ * \param[in] nm the new memory of every region, which must be at least one,
+ *                and at least the number of particles in the region. */
+void container_base::set_arena(const int *nm) {
+	int l,j;
+	size_t tot=0;
+	for(l=0;l<nxyz;l++) {
+		if(nm[l]>max_particle_memory)
+			voro_fatal_error("Absolute maximum memory allocation exceeded",VOROPP_MEMORY_ERROR);
+		tot+=nm[l];
+	}
+#if VOROPP_VERBOSE >=3
+	fprintf(stderr,"Particle arena set to %lu particles\n",(unsigned long) tot);
+#endif
+
+	// Copy the regions into the new arena
+	int *ida=new int[tot],*idp=ida;
+	double *pa=new double[ps*tot],*pp=pa;
+	for(l=0;l<nxyz;l++) {
+		for(j=0;j<co[l];j++) idp[j]=id[l][j];
+		for(j=0;j<ps*co[l];j++) pp[j]=p[l][j];
+		release_block(l);
+		id[l]=idp;p[l]=pp;mem[l]=nm[l];
+		idp+=nm[l];pp+=ps*nm[l];
+	}
+
+	// Replace the old arena
+	delete [] p_arena;
+	delete [] id_arena;
+	id_arena=ida;p_arena=pa;arena_mem=tot;
+}
+
+/** Packs the particles of all regions into a single arena, with every region
+ * taking exactly as much memory as it needs, or room for one particle if it
+ * is empty. This removes the unused memory that regions accumulate as they
+ * grow, and places the particles of neighboring regions next to each other.
+ * Adding a particle to a full region afterwards moves that region out of the
+ * arena, while put_all() rebuilds the arena. */
+void container_base::pack_particles() {
+	int *nm=new int[nxyz];
+	for(int l=0;l<nxyz;l++) nm[l]=co[l]>0?co[l]:1;
+	set_arena(nm);
+	delete [] nm;
 }
 
 /** Import a list of particles from an open file stream into the container.
@@ -347,6 +606,20 @@ void container::import(particle_order &vo,FILE *fp) {
 	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
 }
 
+/** Imports a whole particle file into the container in one bulk insertion.
+ * The file may be in the text format read by the import routine, which is
+ * parsed on several threads, or in the binary format of the particle_import
+ * class, which is memory mapped.
+ * \param[in] filename the name of the file to read.
+ * \param[in] threads the number of threads to parse a text file on and to
+ *                    insert the particles with, or zero for the OpenMP
+ *                    default. */
+void container::import_bulk(const char *filename,int threads) {
+	particle_import pi;
+	pi.load(filename,false,threads);
+	put_all(pi.id,pi.x,pi.y,pi.z,pi.n,threads);
+}
+
 /** Import a list of particles from an open file stream into the container.
  * Entries of five numbers (Particle ID, x position, y position, z position,
  * radius) are searched for. If the file cannot be successfully read, then the
@@ -372,6 +645,20 @@ void container_poly::import(particle_order &vo,FILE *fp) {
 	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
 }
 
+/** Imports a whole particle file into the container in one bulk insertion.
+ * The file may be in the text format read by the import routine, which is
+ * parsed on several threads, or in the binary format of the particle_import
+ * class, which is memory mapped and must hold radii.
+ * \param[in] filename the name of the file to read.
+ * \param[in] threads the number of threads to parse a text file on and to
+ *                    insert the particles with, or zero for the OpenMP
+ *                    default. */
+void container_poly::import_bulk(const char *filename,int threads) {
+	particle_import pi;
+	pi.load(filename,true,threads);
+	put_all(pi.id,pi.x,pi.y,pi.z,pi.r,pi.n,threads);
+}
+
 /** Outputs the a list of all the container regions along with the number of
  * particles stored within each. */
 void container_base::region_count() {
@@ -380,6 +667,138 @@ void container_base::region_count() {
 		printf("Region (%d,%d,%d): %d particles\n",i,j,k,*(cop++));
 }
 
+/** Scales a position within a block to an integer coordinate, clamping it to
+ * the valid range.
+ * \param[in] f the scaled position.
+ * \param[in] mx the largest integer coordinate.
+ * \return The integer coordinate. */
+static inline unsigned int morton_scale(double f,double mx) {
+	return f<0?0:(f>mx?(unsigned int) mx:(unsigned int) f);
+}
+
+/** \brief A function object that orders points along a Morton curve.
+ *
+ * The points are given by triplets of unsigned integer coordinates. Rather than
+ * interleaving the bits of the coordinates into a single key, the comparison
+ * uses the coordinate in which the two points differ in the most significant
+ * bit, so that no bits are lost. Points with equal coordinates are ordered by
+ * index, so that the order is deterministic. */
+struct morton_compare {
+	/** A pointer to the coordinate triplets. */
+	const unsigned int *c;
+	morton_compare(const unsigned int *c_) : c(c_) {}
+	inline bool operator()(int a,int b) const {
+		const unsigned int *ca=c+3*a,*cb=c+3*b;
+		unsigned int x=0,y;
+		int d=0;
+		for(int l=0;l<3;l++) {
+			y=ca[l]^cb[l];
+			if(x<y&&x<(x^y)) {d=l;x=y;}
+		}
+		return x==0?a<b:ca[d]<cb[d];
+	}
+};
+
+/** Reorders the particles within each block along a Morton curve, so that
+ * particles that are close in space are also close in memory, and loops over
+ * the container visit them in that order. The particle IDs move with the
+ * particles. Since the positions of the particles within their blocks change,
+ * any particle_order class referring to the container becomes invalid; the
+ * other version of this routine can be used to update one. Reordering the
+ * particles can alter the numbering of the vertices of the computed cells,
+ * but not the cells themselves. */
+void container_base::sort_particles() {
+	sort_blocks(NULL,NULL);
+}
+
+/** Reorders the particles within each block along a Morton curve, and updates
+ * a particle_order class so that it still refers to the same particles in the
+ * same order.
+ * \param[in,out] vo the ordering class to update. */
+void container_base::sort_particles(particle_order &vo) {
+	int ijk,*off=new int[nxyz+1];
+	off[0]=0;
+	for(ijk=0;ijk<nxyz;ijk++) off[ijk+1]=off[ijk]+co[ijk];
+	int *rk=new int[off[nxyz]];
+	sort_blocks(off,rk);
+	for(int *op=vo.o;op<vo.op;op+=2) op[1]=rk[off[*op]+op[1]];
+	delete [] rk;
+	delete [] off;
+}
+
+/** Reorders the particles within each block along a Morton curve. The
+ * positions within the block are scaled to integers with twenty bits in each
+ * direction. The blocks are sorted in parallel if OpenMP is enabled.
+ * \param[in] off the offset of each block into the rk array, or NULL if the
+ *                new positions are not needed.
+ * \param[out] rk the new position within its block of every particle, indexed
+ *                by block offset and old position. */
+void container_base::sort_blocks(int *off,int *rk) {
+	int ijk,mc=0;
+	for(ijk=0;ijk<nxyz;ijk++) if(co[ijk]>mc) mc=co[ijk];
+	if(mc<2) {
+		if(rk!=NULL) for(ijk=0;ijk<off[nxyz];ijk++) rk[ijk]=0;
+		return;
+	}
+	const double mx=1048575,sx=(mx+1)/boxx,sy=(mx+1)/boxy,sz=(mx+1)/boxz;
+#pragma omp parallel
+	{
+		unsigned int *ic=new unsigned int[3*mc];
+		int i,j,k,l,m,*ix=new int[mc],*tid=new int[mc];
+		double *tp=new double[ps*mc],*pp,lx,ly,lz;
+#pragma omp for schedule(dynamic,16)
+		for(ijk=0;ijk<nxyz;ijk++) {
+			if(co[ijk]<2) {
+				if(rk!=NULL&&co[ijk]==1) rk[off[ijk]]=0;
+				continue;
+			}
+
+			// Scale the positions within the block to integers
+			k=ijk/nxy;j=(ijk-k*nxy)/nx;i=ijk-k*nxy-j*nx;
+			lx=ax+i*boxx;ly=ay+j*boxy;lz=az+k*boxz;
+			for(l=0;l<co[ijk];l++) {
+				pp=p[ijk]+ps*l;
+				ix[l]=l;
+				ic[3*l]=morton_scale((*pp-lx)*sx,mx);
+				ic[3*l+1]=morton_scale((pp[1]-ly)*sy,mx);
+				ic[3*l+2]=morton_scale((pp[2]-lz)*sz,mx);
+			}
+			std::sort(ix,ix+co[ijk],morton_compare(ic));
+
+			// Copy the particles into their new positions
+			for(l=0;l<co[ijk];l++) tid[l]=id[ijk][l];
+			for(l=0;l<ps*co[ijk];l++) tp[l]=p[ijk][l];
+			for(l=0;l<co[ijk];l++) {
+				id[ijk][l]=tid[ix[l]];
+				for(m=0;m<ps;m++) p[ijk][ps*l+m]=tp[ps*ix[l]+m];
+				if(rk!=NULL) rk[off[ijk]+ix[l]]=l;
+			}
+		}
+		delete [] tp;
+		delete [] tid;
+		delete [] ix;
+		delete [] ic;
+	}
+}
+
+/** Stores all of the particles in a particle_order class, visiting the blocks
+ * along a Morton curve, and the particles within each block in the order that
+ * they are stored. A c_loop_order class using the ordering then visits the
+ * particles in that order. Combined with the sort_particles() routine, this
+ * gives a loop along a space-filling curve through the whole container.
+ * \param[out] vo the ordering class to add the particles to. */
+void container_base::morton_order(particle_order &vo) {
+	unsigned int *bc=new unsigned int[3*nxyz];
+	int i,j,k,l,q,*ix=new int[nxyz];
+	for(l=k=0;k<nz;k++) for(j=0;j<ny;j++) for(i=0;i<nx;i++,l++) {
+		ix[l]=l;bc[3*l]=i;bc[3*l+1]=j;bc[3*l+2]=k;
+	}
+	std::sort(ix,ix+nxyz,morton_compare(bc));
+	for(l=0;l<nxyz;l++) for(q=0;q<co[ix[l]];q++) vo.add(ix[l],q);
+	delete [] ix;
+	delete [] bc;
+}
+
 /** Clears a container of particles. */
 void container::clear() {
 	for(int *cop=co;cop<co+nxyz;cop++) *cop=0;
@@ -439,6 +858,16 @@ void container::compute_all_cells() {
 	while(vl.inc());
 }
 
+/** Computes all of the Voronoi cells in the container on several threads, but
+ * does nothing with the output.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+void container::compute_all_cells(int threads) {
+	c_loop_all vl(*this);
+	parallel_discard f;
+	compute_cells<voronoicell>(vl,f,threads);
+}
+
 /** Computes all of the Voronoi cells in the container, but does nothing
  * with the output. It is useful for measuring the pure computation time
  * of the Voronoi algorithm, without any additional calculations such as
@@ -449,6 +878,16 @@ void container_poly::compute_all_cells() {
 	if(vl.start()) do compute_cell(c,vl);while(vl.inc());
 }
 
+/** Computes all of the Voronoi cells in the container on several threads, but
+ * does nothing with the output.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+void container_poly::compute_all_cells(int threads) {
+	c_loop_all vl(*this);
+	parallel_discard f;
+	compute_cells<voronoicell>(vl,f,threads);
+}
+
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
  * without walls, the sum of the Voronoi cell volumes should equal the volume
  * of the container to numerical precision.
@@ -461,6 +900,19 @@ double container::sum_cell_volumes() {
 	return vol;
 }
 
+/** Calculates all of the Voronoi cells on several threads and sums their
+ * volumes. The volumes are summed in the same order as in the serial routine,
+ * so the result does not depend on the number of threads.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container::sum_cell_volumes(int threads) {
+	c_loop_all vl(*this);
+	parallel_volume_sum f;
+	compute_cells<voronoicell>(vl,f,threads);
+	return f.sum();
+}
+
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
  * without walls, the sum of the Voronoi cell volumes should equal the volume
  * of the container to numerical precision.
@@ -473,6 +925,19 @@ double container_poly::sum_cell_volumes() {
 	return vol;
 }
 
+/** Calculates all of the Voronoi cells on several threads and sums their
+ * volumes. The volumes are summed in the same order as in the serial routine,
+ * so the result does not depend on the number of threads.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_poly::sum_cell_volumes(int threads) {
+	c_loop_all vl(*this);
+	parallel_volume_sum f;
+	compute_cells<voronoicell>(vl,f,threads);
+	return f.sum();
+}
+
 /** This function tests to see if a given vector lies within the container
  * bounds and any walls.
  * \param[in] (x,y,z) the position vector to be tested.
@@ -19,6 +19,8 @@
 #include "cell.hh"
 #include "c_loops.hh"
 #include "v_compute.hh"
+#include "c_parallel.hh"
+#include "custom_format.hh"
 #include "rad_option.hh"
 
 namespace voro {
@@ -109,6 +111,11 @@ class wall_list {
  * that are commonly between these two classes, such as those for drawing the
  * domain, and placing particles within the internal data structure.
  *
+ * The particles of all the computational blocks are stored in a single arena,
+ * with the blocks one after another, so that the container needs only a few
+ * large allocations and neighboring blocks are close in memory. The id and p
+ * arrays point to the start of every block within the arena.
+ *
  * The class is derived from the wall_list class, which encapsulates routines
  * for associating walls with the container, and the voro_base class, which
  * encapsulates routines about the underlying computational grid. */
@@ -164,6 +171,10 @@ class container_base : public voro_base, public wall_list {
 		~container_base();
 		bool point_inside(double x,double y,double z);
 		void region_count();
+		void pack_particles();
+		void sort_particles();
+		void sort_particles(particle_order &vo);
+		void morton_order(particle_order &vo);
 		/** Initializes the Voronoi cell prior to a compute_cell
 		 * operation for a specific particle being carried out by a
 		 * voro_compute class. The cell is initialized to fill the
@@ -270,10 +281,40 @@ class container_base : public voro_base, public wall_list {
 			return tp;
 		}
 	protected:
+		/** The arena holding the particle IDs of the regions, which are
+		 * stored one after another. A region that grows beyond its
+		 * memory by a single insertion is moved into its own array. */
+		int *id_arena;
+		/** The arena holding the particle positions of the regions,
+		 * laid out in the same way as the IDs. */
+		double *p_arena;
+		/** The number of particles that the arena can hold. */
+		size_t arena_mem;
+		/** Checks whether the memory of a region is part of the arena.
+		 * \param[in] i the index of the region.
+		 * \return True if the region is in the arena, false if it has
+		 * its own arrays. */
+		inline bool in_arena(int i) {
+			return id[i]>=id_arena&&id[i]<id_arena+arena_mem;
+		}
+		/** Frees the memory of a region, unless it is part of the
+		 * arena.
+		 * \param[in] i the index of the region. */
+		inline void release_block(int i) {
+			if(!in_arena(i)) {delete [] id[i];delete [] p[i];}
+		}
 		void add_particle_memory(int i);
+		void set_particle_memory(int i,int nmem);
+		void set_arena(const int *nm);
+		void sort_blocks(int *off,int *rk);
 		bool put_locate_block(int &ijk,double &x,double &y,double &z);
+		void put_all_locate(const double *xs,const double *ys,const double *zs,int n,int *sl);
+		template<class c_class>
+		void find_voronoi_cells(c_class &con,int hx,int hy,int hz,const double *xs,const double *ys,const double *zs,int n,int *pids,int *imgs,int threads);
 		inline bool put_remap(int &ijk,double &x,double &y,double &z);
 		inline bool remap(int &ai,int &aj,int &ak,int &ci,int &cj,int &ck,double &x,double &y,double &z,int &ijk);
+		template<class c_class>
+		friend class voro_update;
 };
 
 /** \brief Extension of the container_base class for computing regular Voronoi
@@ -289,8 +330,10 @@ class container : public container_base, public radius_mono {
 		void clear();
 		void put(int n,double x,double y,double z);
 		void put(particle_order &vo,int n,double x,double y,double z);
+		void put_all(const int *ids,const double *xs,const double *ys,const double *zs,int n,int threads=0);
 		void import(FILE *fp=stdin);
 		void import(particle_order &vo,FILE *fp=stdin);
+		void import_bulk(const char *filename,int threads=0);
 		/** Imports a list of particles from an open file stream into
 		 * the container. Entries of four numbers (Particle ID, x
 		 * position, y position, z position) are searched for. If the
@@ -318,7 +361,9 @@ class container : public container_base, public radius_mono {
 			fclose(fp);
 		}
 		void compute_all_cells();
+		void compute_all_cells(int threads);
 		double sum_cell_volumes();
+		double sum_cell_volumes(int threads);
 		/** Dumps particle IDs and positions to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
@@ -431,23 +476,25 @@ class container : public container_base, public radius_mono {
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
 			int ijk,q;double *pp;
+			custom_format cf(format);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
 				} while(vl.inc());
 			}
 		}
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
+		void find_voronoi_cells(const double *xs,const double *ys,const double *zs,int n,int *pids,int *imgs,int threads=0);
 		/** Computes the Voronoi cell for a particle currently being
 		 * referenced by a loop class.
 		 * \param[out] c a Voronoi cell class in which to store the
@@ -460,6 +507,18 @@ class container : public container_base, public radius_mono {
 		inline bool compute_cell(v_cell &c,c_loop &vl) {
 			return vc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
 		}
+		/** Computes the Voronoi cells of all particles referenced by a
+		 * loop class on several threads, using the
+		 * compute_cells_parallel routine.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] f the function object to call for every
+		 *              particle.
+		 * \param[in] threads the number of threads to use, or zero for
+		 *                    the OpenMP default. */
+		template<class v_cell,class c_loop,class f_cell>
+		inline void compute_cells(c_loop &vl,f_cell &f,int threads) {
+			compute_cells_parallel<v_cell>(*this,vc.hx,vc.hy,vc.hz,vl,f,threads);
+		}
 		/** Computes the Voronoi cell for given particle.
 		 * \param[out] c a Voronoi cell class in which to store the
 		 * 		 computed cell.
@@ -511,8 +570,10 @@ class container_poly : public container_base, public radius_poly {
 		void clear();
 		void put(int n,double x,double y,double z,double r);
 		void put(particle_order &vo,int n,double x,double y,double z,double r);
+		void put_all(const int *ids,const double *xs,const double *ys,const double *zs,const double *rs,int n,int threads=0);
 		void import(FILE *fp=stdin);
 		void import(particle_order &vo,FILE *fp=stdin);
+		void import_bulk(const char *filename,int threads=0);
 		/** Imports a list of particles from an open file stream into
 		 * the container_poly class. Entries of five numbers (Particle
 		 * ID, x position, y position, z position, radius) are searched
@@ -540,7 +601,9 @@ class container_poly : public container_base, public radius_poly {
 			fclose(fp);
 		}
 		void compute_all_cells();
+		void compute_all_cells(int threads);
 		double sum_cell_volumes();
+		double sum_cell_volumes(int threads);
 		/** Dumps particle IDs, positions and radii to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
@@ -655,17 +718,18 @@ class container_poly : public container_base, public radius_poly {
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
 			int ijk,q;double *pp;
+			custom_format cf(format);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
 				} while(vl.inc());
 			}
 		}
@@ -681,6 +745,18 @@ class container_poly : public container_base, public radius_poly {
 		inline bool compute_cell(v_cell &c,c_loop &vl) {
 			return vc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
 		}
+		/** Computes the Voronoi cells of all particles referenced by a
+		 * loop class on several threads, using the
+		 * compute_cells_parallel routine.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] f the function object to call for every
+		 *              particle.
+		 * \param[in] threads the number of threads to use, or zero for
+		 *                    the OpenMP default. */
+		template<class v_cell,class c_loop,class f_cell>
+		inline void compute_cells(c_loop &vl,f_cell &f,int threads) {
+			compute_cells_parallel<v_cell>(*this,vc.hx,vc.hy,vc.hz,vl,f,threads);
+		}
 		/** Computes the Voronoi cell for given particle.
 		 * \param[out] c a Voronoi cell class in which to store the
 		 * 		 computed cell.
@@ -719,6 +795,7 @@ class container_poly : public container_base, public radius_poly {
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
+		void find_voronoi_cells(const double *xs,const double *ys,const double *zs,int n,int *pids,int *imgs,int threads=0);
 	private:
 		voro_compute<container_poly> vc;
 		friend class voro_compute<container_poly>;
@@ -503,6 +503,16 @@ void container_periodic::compute_all_cells() {
 	while(vl.inc());
 }
 
+/** Computes all of the Voronoi cells in the container on several threads, but
+ * does nothing with the output.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+void container_periodic::compute_all_cells(int threads) {
+	c_loop_all_periodic vl(*this);
+	parallel_discard f;
+	compute_cells<voronoicell>(vl,f,threads);
+}
+
 /** Computes all of the Voronoi cells in the container, but does nothing
  * with the output. It is useful for measuring the pure computation time
  * of the Voronoi algorithm, without any additional calculations such as
@@ -513,6 +523,16 @@ void container_periodic_poly::compute_all_cells() {
 	if(vl.start()) do compute_cell(c,vl);while(vl.inc());
 }
 
+/** Computes all of the Voronoi cells in the container on several threads, but
+ * does nothing with the output.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+void container_periodic_poly::compute_all_cells(int threads) {
+	c_loop_all_periodic vl(*this);
+	parallel_discard f;
+	compute_cells<voronoicell>(vl,f,threads);
+}
+
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
  * without walls, the sum of the Voronoi cell volumes should equal the volume
  * of the container to numerical precision.
@@ -525,6 +545,19 @@ double container_periodic::sum_cell_volumes() {
 	return vol;
 }
 
+/** Calculates all of the Voronoi cells on several threads and sums their
+ * volumes. The volumes are summed in the same order as in the serial routine,
+ * so the result does not depend on the number of threads.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_periodic::sum_cell_volumes(int threads) {
+	c_loop_all_periodic vl(*this);
+	parallel_volume_sum f;
+	compute_cells<voronoicell>(vl,f,threads);
+	return f.sum();
+}
+
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
  * without walls, the sum of the Voronoi cell volumes should equal the volume
  * of the container to numerical precision.
@@ -537,6 +570,19 @@ double container_periodic_poly::sum_cell_volumes() {
 	return vol;
 }
 
+/** Calculates all of the Voronoi cells on several threads and sums their
+ * volumes. The volumes are summed in the same order as in the serial routine,
+ * so the result does not depend on the number of threads.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_periodic_poly::sum_cell_volumes(int threads) {
+	c_loop_all_periodic vl(*this);
+	parallel_volume_sum f;
+	compute_cells<voronoicell>(vl,f,threads);
+	return f.sum();
+}
+
 /** This routine creates all periodic images of the particles. It is meant for
  * diagnostic purposes only, since usually periodic images are dynamically
  * created in when they are referenced. */
@@ -19,6 +19,8 @@
 #include "cell.hh"
 #include "c_loops.hh"
 #include "v_compute.hh"
+#include "c_parallel.hh"
+#include "custom_format.hh"
 #include "unitcell.hh"
 #include "rad_option.hh"
 
@@ -187,15 +189,18 @@ class container_periodic_base : public unitcell, public voro_base {
 		 * where the image block may comprise of particles from up to
 		 * two primary blocks. Otherwise is calls the more complex
 		 * create_vertical_image where the image block may comprise of
-		 * particles from up to four primary blocks.
+		 * particles from up to four primary blocks. Images that are
+		 * already complete are left untouched, so that once all
+		 * images exist, this routine only reads the container.
 		 * \param[in] (di,dj,dk) the coordinates of the image block to
 		 *                       create. */
 		inline void create_periodic_image(int di,int dj,int dk) {
 			if(di<0||di>=nx||dj<0||dj>=oy||dk<0||dk>=oz)
 				voro_fatal_error("Constructing periodic image for nonexistent point",VOROPP_INTERNAL_ERROR);
+			int dijk=di+nx*(dj+oy*dk);
 			if(dk>=ez&&dk<wz) {
-				if(dj<ey||dj>=wy) create_side_image(di,dj,dk);
-			} else create_vertical_image(di,dj,dk);
+				if((dj<ey||dj>=wy)&&img[dijk]!=3) create_side_image(di,dj,dk);
+			} else if(img[dijk]!=15) create_vertical_image(di,dj,dk);
 		}
 		void create_side_image(int di,int dj,int dk);
 		void create_vertical_image(int di,int dj,int dk);
@@ -246,7 +251,9 @@ class container_periodic : public container_periodic_base, public radius_mono {
 			fclose(fp);
 		}
 		void compute_all_cells();
+		void compute_all_cells(int threads);
 		double sum_cell_volumes();
+		double sum_cell_volumes(int threads);
 		/** Dumps particle IDs and positions to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
@@ -359,17 +366,18 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
 			int ijk,q;double *pp;
+			custom_format cf(format);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
 				} while(vl.inc());
 			}
 		}
@@ -388,6 +396,20 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		inline bool compute_cell(v_cell &c,c_loop &vl) {
 			return vc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
 		}
+		/** Computes the Voronoi cells of all particles referenced by a
+		 * loop class on several threads, using the
+		 * compute_cells_parallel routine. All periodic images are created
+		 * beforehand, so that the threads only read the container.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] f the function object to call for every
+		 *              particle.
+		 * \param[in] threads the number of threads to use, or zero for
+		 *                    the OpenMP default. */
+		template<class v_cell,class c_loop,class f_cell>
+		inline void compute_cells(c_loop &vl,f_cell &f,int threads) {
+			create_all_images();
+			compute_cells_parallel<v_cell>(*this,vc.hx,vc.hy,vc.hz,vl,f,threads);
+		}
 		/** Computes the Voronoi cell for given particle.
 		 * \param[out] c a Voronoi cell class in which to store the
 		 * 		 computed cell.
@@ -467,7 +489,9 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 			fclose(fp);
 		}
 		void compute_all_cells();
+		void compute_all_cells(int threads);
 		double sum_cell_volumes();
+		double sum_cell_volumes(int threads);
 		/** Dumps particle IDs, positions and radii to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
@@ -582,17 +606,18 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
 			int ijk,q;double *pp;
+			custom_format cf(format);
 			if(contains_neighbor(format)) {
 				voronoicell_neighbor c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
 				} while(vl.inc());
 			} else {
 				voronoicell c;
 				if(vl.start()) do if(compute_cell(c,vl)) {
 					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
+					cf.output(c,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
 				} while(vl.inc());
 			}
 		}
@@ -608,6 +633,20 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		inline bool compute_cell(v_cell &c,c_loop &vl) {
 			return vc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
 		}
+		/** Computes the Voronoi cells of all particles referenced by a
+		 * loop class on several threads, using the
+		 * compute_cells_parallel routine. All periodic images are created
+		 * beforehand, so that the threads only read the container.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] f the function object to call for every
+		 *              particle.
+		 * \param[in] threads the number of threads to use, or zero for
+		 *                    the OpenMP default. */
+		template<class v_cell,class c_loop,class f_cell>
+		inline void compute_cells(c_loop &vl,f_cell &f,int threads) {
+			create_all_images();
+			compute_cells_parallel<v_cell>(*this,vc.hx,vc.hy,vc.hz,vl,f,threads);
+		}
 		/** Computes the Voronoi cell for given particle.
 		 * \param[out] c a Voronoi cell class in which to store the
 		 * 		 computed cell.
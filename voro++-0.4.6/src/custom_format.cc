@@ -0,0 +1,348 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file custom_format.cc
+ * \brief Function implementations for the custom_format class. */
+
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#include "custom_format.hh"
+
+namespace voro {
+
+/** The bits of the mask of quantities that a custom format needs. */
+static const unsigned int need_volume=1,need_centroid=2,need_max_radius=4,
+	need_edges=8,need_edge_distance=16,need_perimeters=32,need_faces=64,
+	need_area=128,need_freq=256,need_orders=512,need_face_areas=1024,
+	need_face_vertices=2048,need_normals=4096,need_neighbors=8192;
+
+/** The size that the output buffer is allowed to reach before it is written
+ * to the file. */
+static const size_t custom_format_flush=1<<16;
+
+/** The powers of ten that can be represented exactly as doubles. */
+static const double ten_pow[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,
+	1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+/** The class constructor compiles a custom output string into a list of
+ * operations. A percent sign that is not followed by a known character is
+ * printed as it stands, and a percent sign at the end of the string is
+ * ignored.
+ * \param[in] format the custom output string. */
+custom_format::custom_format(const char *format) : need(0), buf(NULL), len(0),
+	mem(0), bfp(NULL) {
+	const char *fmp=format;
+	while(*fmp!=0) {
+		if(*fmp=='%') {
+			fmp++;
+			switch(*fmp) {
+				case 'i': case 'x': case 'y': case 'z': case 'q':
+				case 'r': case 'w': case 'p': case 'P': case 'o':
+					break;
+				case 'm': need|=need_max_radius;break;
+				case 'g': need|=need_edges;break;
+				case 'E': need|=need_edge_distance;break;
+				case 'e': need|=need_perimeters;break;
+				case 's': need|=need_faces;break;
+				case 'F': need|=need_area;break;
+				case 'A': need|=need_freq;break;
+				case 'a': need|=need_orders;break;
+				case 'f': need|=need_face_areas;break;
+				case 't': need|=need_face_vertices;break;
+				case 'l': need|=need_normals;break;
+				case 'n': need|=need_neighbors;break;
+				case 'v': need|=need_volume;break;
+				case 'c': case 'C': need|=need_centroid;break;
+				case 0: continue;
+				default: add_literal(fmp-1,2);fmp++;continue;
+			}
+			op.push_back(*fmp);op.push_back(0);op.push_back(0);
+		} else add_literal(fmp,1);
+		fmp++;
+	}
+	add_literal("\n",1);
+}
+
+/** The class destructor writes out any remaining output and frees the
+ * buffer. */
+custom_format::~custom_format() {
+	flush();
+	free(buf);
+}
+
+/** Adds a piece of literal text to the list of operations, merging it with
+ * the previous operation if that also prints literal text.
+ * \param[in] s a pointer to the text.
+ * \param[in] l the number of characters. */
+void custom_format::add_literal(const char *s,int l) {
+	int n=op.size();
+	if(n==0||op[n-3]!=0) {
+		op.push_back(0);op.push_back(lit.size());op.push_back(0);
+		n+=3;
+	}
+	lit.insert(lit.end(),s,s+l);
+	op[n-1]+=l;
+}
+
+/** Writes the contents of the buffer to its file. */
+void custom_format::flush() {
+	if(len>0) {
+		if(fwrite(buf,1,len,bfp)!=len) voro_fatal_error("File output error",VOROPP_FILE_ERROR);
+		len=0;
+	}
+}
+
+/** Enlarges the buffer.
+ * \param[in] n the minimum number of characters that the buffer must hold. */
+void custom_format::grow(size_t n) {
+	size_t nmem=mem>0?mem<<1:4096;
+	while(nmem<n) nmem<<=1;
+	char *nbuf=static_cast<char*>(realloc(buf,nmem));
+	if(nbuf==NULL) voro_fatal_error("Unable to allocate output buffer",VOROPP_MEMORY_ERROR);
+	buf=nbuf;mem=nmem;
+}
+
+/** Computes the quantities of a Voronoi cell that the format needs.
+ * \param[in] c the Voronoi cell. */
+void custom_format::compute(voronoicell_base &c) {
+	if(need&need_volume) vol=c.volume();
+	if(need&need_centroid) c.centroid(cx,cy,cz);
+	if(need&need_max_radius) mrs=0.25*c.max_radius_squared();
+	if(need&need_edges) ne=c.number_of_edges();
+	if(need&need_edge_distance) ted=c.total_edge_distance();
+	if(need&need_perimeters) c.face_perimeters(fper);
+	if(need&need_faces) nf=c.number_of_faces();
+	if(need&need_area) sa=c.surface_area();
+	if(need&need_freq) c.face_freq_table(ffreq);
+	if(need&need_orders) c.face_orders(ford);
+	if(need&need_face_areas) c.face_areas(farea);
+	if(need&need_face_vertices) c.face_vertices(fvert);
+	if(need&need_normals) c.normals(fnorm);
+	if(need&need_neighbors) c.neighbors(nbr);
+}
+
+/** Prints the custom output for a Voronoi cell into the buffer, and writes
+ * the buffer to the file once it is large.
+ * \param[in] c the Voronoi cell.
+ * \param[in] i the ID of the particle associated with the cell.
+ * \param[in] (x,y,z) the position of the particle.
+ * \param[in] r a radius associated with the particle.
+ * \param[in] fp the file handle to write to. */
+void custom_format::output(voronoicell_base &c,int i,double x,double y,double z,double r,FILE *fp) {
+	if(fp!=bfp) {flush();bfp=fp;}
+	compute(c);
+	for(std::vector<int>::iterator it=op.begin();it<op.end();it+=3) {
+		switch(*it) {
+
+			// Literal text
+			case 0: reserve(it[2]);
+				memcpy(buf+len,&lit[it[1]],it[2]);len+=it[2];
+				break;
+
+			// Particle-related output
+			case 'i': put_int(i);break;
+			case 'x': put_double(x);break;
+			case 'y': put_double(y);break;
+			case 'z': put_double(z);break;
+			case 'q': put_double(x);put(' ');put_double(y);put(' ');put_double(z);break;
+			case 'r': put_double(r);break;
+
+			// Vertex-related output
+			case 'w': put_int(c.p);break;
+			case 'p': put_vertices(c,0,0,0);break;
+			case 'P': put_vertices(c,x,y,z);break;
+			case 'o': put_vertex_orders(c);break;
+			case 'm': put_double(mrs);break;
+
+			// Edge-related output
+			case 'g': put_int(ne);break;
+			case 'E': put_double(ted);break;
+			case 'e': put_vector(fper);break;
+
+			// Face-related output
+			case 's': put_int(nf);break;
+			case 'F': put_double(sa);break;
+			case 'A': put_vector(ffreq);break;
+			case 'a': put_vector(ford);break;
+			case 'f': put_vector(farea);break;
+			case 't': put_face_vertices(fvert);break;
+			case 'l': put_positions(fnorm);break;
+			case 'n': put_vector(nbr);break;
+
+			// Volume-related output
+			case 'v': put_double(vol);break;
+			case 'c': put_double(cx);put(' ');put_double(cy);put(' ');put_double(cz);break;
+			case 'C': put_double(x+cx);put(' ');put_double(y+cy);put(' ');put_double(z+cz);
+		}
+	}
+	if(len>=custom_format_flush) flush();
+}
+
+/** Appends an integer to the buffer.
+ * \param[in] i the integer. */
+void custom_format::put_int(int i) {
+	reserve(16);
+	len+=voro_format_int(buf+len,i);
+}
+
+/** Appends a floating point number to the buffer, in the same way as the
+ * printf "%g" format.
+ * \param[in] d the number. */
+void custom_format::put_double(double d) {
+	reserve(32);
+	len+=voro_format_double(buf+len,d);
+}
+
+/** Appends a vector of integers to the buffer, separated by spaces.
+ * \param[in] v the vector. */
+void custom_format::put_vector(std::vector<int> &v) {
+	for(unsigned int k=0;k<v.size();k++) {
+		if(k>0) put(' ');
+		put_int(v[k]);
+	}
+}
+
+/** Appends a vector of floating point numbers to the buffer, separated by
+ * spaces.
+ * \param[in] v the vector. */
+void custom_format::put_vector(std::vector<double> &v) {
+	for(unsigned int k=0;k<v.size();k++) {
+		if(k>0) put(' ');
+		put_double(v[k]);
+	}
+}
+
+/** Appends a vector of positions to the buffer as bracketed triplets, in the
+ * same way as voro_print_positions().
+ * \param[in] v the vector. */
+void custom_format::put_positions(std::vector<double> &v) {
+	for(unsigned int k=0;k+2<v.size();k+=3) {
+		if(k>0) put(' ');
+		put('(');put_double(v[k]);put(',');put_double(v[k+1]);
+		put(',');put_double(v[k+2]);put(')');
+	}
+}
+
+/** Appends a vector of face vertex information to the buffer as bracketed
+ * lists, in the same way as voro_print_face_vertices().
+ * \param[in] v the vector. */
+void custom_format::put_face_vertices(std::vector<int> &v) {
+	unsigned int j,k=0;
+	while(k<v.size()) {
+		if(k>0) put(' ');
+		j=k+1+v[k];k++;
+		put('(');
+		if(k<j) {
+			put_int(v[k++]);
+			while(k<j) {put(',');put_int(v[k++]);}
+		}
+		put(')');
+	}
+}
+
+/** Appends the vertices of a Voronoi cell to the buffer as bracketed
+ * triplets.
+ * \param[in] c the Voronoi cell.
+ * \param[in] (x,y,z) the position vector to add to the vertices. */
+void custom_format::put_vertices(voronoicell_base &c,double x,double y,double z) {
+	for(int k=0;k<c.p;k++) {
+		if(k>0) put(' ');
+		put('(');put_double(x+c.pt(k,0)*0.5);put(',');put_double(y+c.pt(k,1)*0.5);
+		put(',');put_double(z+c.pt(k,2)*0.5);put(')');
+	}
+}
+
+/** Appends the orders of the vertices of a Voronoi cell to the buffer.
+ * \param[in] c the Voronoi cell. */
+void custom_format::put_vertex_orders(voronoicell_base &c) {
+	for(int k=0;k<c.p;k++) {
+		if(k>0) put(' ');
+		put_int(c.nu[k]);
+	}
+}
+
+/** Writes an integer in decimal.
+ * \param[out] s the string to write to, which must have room for twelve
+ *               characters.
+ * \param[in] i the integer.
+ * \return The number of characters written. */
+int voro_format_int(char *s,int i) {
+	char t[12],*tp=t;
+	int l=0;
+	unsigned int u=i<0?0u-(unsigned int) i:(unsigned int) i;
+	if(i<0) s[l++]='-';
+	do {*(tp++)='0'+u%10;u/=10;} while(u>0);
+	while(tp>t) s[l++]=*(--tp);
+	return l;
+}
+
+/** Writes a floating point number in the same way as the printf "%g" format,
+ * with six significant digits. Numbers whose magnitude is between 1e-15 and
+ * 1e15 are scaled by a power of ten that is exact in double precision, and
+ * rounded to six digits. The scaled number is within a tiny fraction of its
+ * exact value, so that the rounding is correct unless the number lies almost
+ * exactly halfway between two six-digit values. In that case, and for all
+ * other numbers, the routine uses sprintf.
+ * \param[out] s the string to write to, which must have room for thirty-two
+ *               characters.
+ * \param[in] d the number.
+ * \return The number of characters written. */
+int voro_format_double(char *s,double d) {
+	double a=fabs(d);
+	if(!(a>=1e-15&&a<1e15)) {
+		if(d==0) {
+			if(1/d<0) {s[0]='-';s[1]='0';return 2;}
+			*s='0';return 1;
+		}
+		return sprintf(s,"%g",d);
+	}
+
+	// Scale the number to lie between 1e5 and 1e6, and round it
+	int k=5-int(floor(log10(a)));
+	double sc=k>=0?a*ten_pow[k]:a/ten_pow[-k];
+	if(sc<1e5||sc>=1e6) {
+		k+=sc<1e5?1:-1;
+		sc=k>=0?a*ten_pow[k]:a/ten_pow[-k];
+	}
+	double fl=floor(sc);
+	if(fabs(sc-fl-0.5)<1e-6) return sprintf(s,"%g",d);
+	int r=int(fl)+(sc-fl>0.5?1:0);
+	if(r==1000000) {r=100000;k--;}
+
+	// Extract the digits, and count the significant ones
+	char dg[6];
+	int j,l=0,nd=6,ex=5-k;
+	for(j=5;j>=0;j--) {dg[j]='0'+r%10;r/=10;}
+	while(nd>1&&dg[nd-1]=='0') nd--;
+
+	// Write the digits in exponential or fixed notation
+	if(d<0) s[l++]='-';
+	if(ex<-4||ex>=6) {
+		s[l++]=dg[0];
+		if(nd>1) {
+			s[l++]='.';
+			for(j=1;j<nd;j++) s[l++]=dg[j];
+		}
+		s[l++]='e';
+		if(ex<0) {s[l++]='-';ex=-ex;} else s[l++]='+';
+		s[l++]='0'+ex/10;s[l++]='0'+ex%10;
+	} else if(ex>=0) {
+		for(j=0;j<=ex;j++) s[l++]=dg[j];
+		if(nd>ex+1) {
+			s[l++]='.';
+			for(;j<nd;j++) s[l++]=dg[j];
+		}
+	} else {
+		s[l++]='0';s[l++]='.';
+		for(j=0;j<-ex-1;j++) s[l++]='0';
+		for(j=0;j<nd;j++) s[l++]=dg[j];
+	}
+	return l;
+}
+
+}
@@ -0,0 +1,117 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file custom_format.hh
+ * \brief Header file for the custom_format class. */
+
+#ifndef VOROPP_CUSTOM_FORMAT_HH
+#define VOROPP_CUSTOM_FORMAT_HH
+
+#include <cstdio>
+#include <vector>
+
+#include "config.hh"
+#include "cell.hh"
+
+namespace voro {
+
+/** \brief A custom output string, compiled for printing many Voronoi cells.
+ *
+ * This class parses a custom output string, in the format used by the
+ * voronoicell_base::output_custom() routine, once into a list of operations,
+ * so that the string does not need to be parsed again for every cell. Every
+ * quantity that the string refers to is computed once per cell, even if it is
+ * printed several times, into arrays that are kept between cells. The output
+ * is assembled in a buffer with dedicated number formatting routines, and the
+ * buffer is written to the file in large pieces. The output is identical to
+ * that of printing every cell with output_custom().
+ *
+ * Since the output is buffered, it only reaches the file once the buffer is
+ * flushed, which happens when the class is destroyed or flush() is called, or
+ * when output is sent to a different file. */
+class custom_format {
+	public:
+		custom_format(const char *format);
+		~custom_format();
+		void output(voronoicell_base &c,int i,double x,double y,double z,double r,FILE *fp);
+		void flush();
+	private:
+		/** The list of operations, stored as triplets of a directive
+		 * character, and the offset and length of a piece of literal
+		 * text. A directive character of zero prints the literal text.
+		 */
+		std::vector<int> op;
+		/** The literal text of the format. */
+		std::vector<char> lit;
+		/** A bitmask of the quantities that the format needs to be
+		 * computed for every cell. */
+		unsigned int need;
+		/** The output buffer. */
+		char *buf;
+		/** The number of characters in the output buffer. */
+		size_t len;
+		/** The memory allocated for the output buffer. */
+		size_t mem;
+		/** The file that the characters in the buffer are for. */
+		FILE *bfp;
+		/** The volume of the cell. */
+		double vol;
+		/** The centroid of the cell, relative to the particle. */
+		double cx,cy,cz;
+		/** The maximum radius squared of a vertex. */
+		double mrs;
+		/** The total edge distance. */
+		double ted;
+		/** The surface area. */
+		double sa;
+		/** The number of edges. */
+		int ne;
+		/** The number of faces. */
+		int nf;
+		/** The face perimeters. */
+		std::vector<double> fper;
+		/** The face areas. */
+		std::vector<double> farea;
+		/** The face normals. */
+		std::vector<double> fnorm;
+		/** The face frequency table. */
+		std::vector<int> ffreq;
+		/** The face orders. */
+		std::vector<int> ford;
+		/** The face vertices. */
+		std::vector<int> fvert;
+		/** The neighbors of the faces. */
+		std::vector<int> nbr;
+		void add_literal(const char *s,int l);
+		void compute(voronoicell_base &c);
+		/** Ensures that the buffer has room for a number of extra
+		 * characters.
+		 * \param[in] n the number of characters. */
+		inline void reserve(size_t n) {
+			if(len+n>mem) grow(len+n);
+		}
+		void grow(size_t n);
+		/** Appends a character to the buffer.
+		 * \param[in] ch the character. */
+		inline void put(char ch) {
+			reserve(1);buf[len++]=ch;
+		}
+		void put_int(int i);
+		void put_double(double d);
+		void put_vector(std::vector<int> &v);
+		void put_vector(std::vector<double> &v);
+		void put_positions(std::vector<double> &v);
+		void put_face_vertices(std::vector<int> &v);
+		void put_vertices(voronoicell_base &c,double x,double y,double z);
+		void put_vertex_orders(voronoicell_base &c);
+};
+
+int voro_format_int(char *s,int i);
+int voro_format_double(char *s,double d);
+
+}
+
+#endif
@@ -0,0 +1,278 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_import.cc
+ * \brief Function implementations for the particle_import class. */
+
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+
+#include "config.hh"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if VOROPP_MMAP==1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "common.hh"
+#include "p_import.hh"
+
+namespace voro {
+
+/** The eight characters at the start of a binary particle file. */
+static const char binary_magic[8]={'V','O','R','O','+','+','B','\0'};
+
+/** The version of the binary particle format. */
+static const int binary_version=1;
+
+/** The size of the header of a binary particle file, in bytes. */
+static const size_t binary_header=24;
+
+/** The class constructor sets up an empty set of particles. */
+particle_import::particle_import() : n(0), radii(false), id(NULL), x(NULL),
+	y(NULL), z(NULL), r(NULL), buf(NULL), buf_len(0), mapped(false) {}
+
+/** The class destructor releases the particle data. */
+particle_import::~particle_import() {
+	clear();
+}
+
+/** Releases the particle data, unmapping or freeing a binary file and
+ * releasing the arrays read from a text file. */
+void particle_import::clear() {
+	if(buf!=NULL) {
+#if VOROPP_MMAP==1
+		if(mapped) munmap(buf,buf_len);
+		else
+#endif
+		free(buf);
+		buf=NULL;buf_len=0;mapped=false;
+	}
+	std::vector<int>().swap(tid);
+	std::vector<double>().swap(tv);
+	n=0;radii=false;
+	id=NULL;x=y=z=r=NULL;
+}
+
+/** Checks whether a file starts with the header of the binary particle
+ * format.
+ * \param[in] filename the name of the file to check.
+ * \return True if the file is a binary particle file, false otherwise. */
+bool particle_import::is_binary(const char *filename) {
+	char h[8];
+	FILE *fp=safe_fopen(filename,"rb");
+	bool bin=fread(h,1,8,fp)==8&&memcmp(h,binary_magic,8)==0;
+	fclose(fp);
+	return bin;
+}
+
+/** Reads a particle file, choosing the binary or text routine depending on
+ * whether the file starts with the binary header.
+ * \param[in] filename the name of the file to read.
+ * \param[in] radii_ whether the particles have radii. For text files, this
+ *                   sets whether there are five numbers per particle. For
+ *                   binary files, it causes a fatal error if the file has no
+ *                   radii.
+ * \param[in] threads the number of threads to parse a text file on, or zero
+ *                    for the OpenMP default. */
+void particle_import::load(const char *filename,bool radii_,int threads) {
+	if(is_binary(filename)) {
+		load_binary(filename);
+		if(radii_&&!radii) voro_fatal_error("Binary particle file has no radii",VOROPP_FILE_ERROR);
+	} else load_text(filename,radii_,threads);
+}
+
+/** Reads a binary particle file. If memory mapping is available, then the
+ * file is mapped and the arrays point into it; otherwise it is read into
+ * memory in one piece.
+ * \param[in] filename the name of the file to read. */
+void particle_import::load_binary(const char *filename) {
+	clear();
+#if VOROPP_MMAP==1
+	int fd=open(filename,O_RDONLY);
+	struct stat st;
+	if(fd<0||fstat(fd,&st)!=0) {
+		fprintf(stderr,"voro++: Unable to open file '%s'\n",filename);
+		exit(VOROPP_FILE_ERROR);
+	}
+	buf_len=st.st_size;
+	if(buf_len>0) {
+		void *m=mmap(NULL,buf_len,PROT_READ,MAP_PRIVATE,fd,0);
+		if(m==MAP_FAILED) voro_fatal_error("Unable to memory map particle file",VOROPP_FILE_ERROR);
+		buf=static_cast<char*>(m);mapped=true;
+	}
+	close(fd);
+#else
+	FILE *fp=safe_fopen(filename,"rb");
+	fseek(fp,0,SEEK_END);
+	buf_len=ftell(fp);
+	fseek(fp,0,SEEK_SET);
+	buf=static_cast<char*>(malloc(buf_len>0?buf_len:1));
+	if(fread(buf,1,buf_len,fp)!=buf_len) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	fclose(fp);
+#endif
+
+	// Check the header and that the file is long enough to hold the
+	// particles that it declares
+	int h[4];
+	if(buf_len<binary_header||memcmp(buf,binary_magic,8)!=0)
+		voro_fatal_error("Not a binary particle file",VOROPP_FILE_ERROR);
+	memcpy(h,buf+8,4*sizeof(int));
+	if(h[0]!=binary_version||h[2]<0)
+		voro_fatal_error("Unsupported binary particle file",VOROPP_FILE_ERROR);
+	radii=(h[1]&1)!=0;n=h[2];
+	size_t ido=binary_header,po=ido+((sizeof(int)*n+7)&~((size_t) 7));
+	if(buf_len<po+sizeof(double)*n*(radii?4:3))
+		voro_fatal_error("Binary particle file is truncated",VOROPP_FILE_ERROR);
+
+	// Set the pointers to the arrays
+	id=reinterpret_cast<const int*>(buf+ido);
+	x=reinterpret_cast<const double*>(buf+po);
+	y=x+n;z=y+n;r=radii?z+n:NULL;
+}
+
+/** Reads a text particle file with four numbers per particle (ID and
+ * position), or five if the particles have radii. The file is read into
+ * memory and split at line breaks into one piece per thread, and the pieces
+ * are parsed in parallel. If a particle is split across lines such that a
+ * piece ends within it, the whole file is parsed again on one thread. A
+ * malformed entry causes a fatal error, as in the import routines of the
+ * containers.
+ * \param[in] filename the name of the file to read.
+ * \param[in] radii_ whether there are five numbers per particle.
+ * \param[in] threads the number of threads to use, or zero for the OpenMP
+ *                    default. */
+void particle_import::load_text(const char *filename,bool radii_,int threads) {
+	clear();
+	radii=radii_;
+	int ps=radii?4:3;
+
+	// Read the whole file into a null-terminated buffer
+	FILE *fp=safe_fopen(filename,"rb");
+	size_t len=0,cap=1<<16,k;
+	char *s=static_cast<char*>(malloc(cap));
+	while((k=fread(s+len,1,cap-len,fp))>0) {
+		len+=k;
+		if(len==cap) {cap<<=1;s=static_cast<char*>(realloc(s,cap));}
+	}
+	fclose(fp);
+	s[len]='\0';
+
+	// Split the buffer at line breaks into one piece per thread
+	int nt=threads>0?threads:1,t;
+#ifdef _OPENMP
+	if(threads<=0) nt=omp_get_max_threads();
+#endif
+	if(len<((size_t) 1<<16)) nt=1;
+	std::vector<const char*> cut(nt+1);
+	cut[0]=s;cut[nt]=s+len;
+	for(t=1;t<nt;t++) {
+		const char *c=s+len*t/nt;
+		if(c<cut[t-1]) c=cut[t-1];
+		while(c<s+len&&*c!='\n') c++;
+		cut[t]=c<s+len?c+1:c;
+	}
+
+	// Parse the pieces into per-thread arrays
+	std::vector<std::vector<int> > vid(nt);
+	std::vector<std::vector<double> > vv(nt);
+	std::vector<char> part(nt,0);
+#pragma omp parallel for num_threads(nt)
+	for(t=0;t<nt;t++) {
+		bool pt=false;
+		parse_text(cut[t],cut[t+1],ps,vid[t],vv[t],pt);
+		part[t]=pt;
+	}
+	for(t=0;t<nt;t++) if(part[t]) break;
+	if(t<nt) {
+		if(nt>1) {
+			vid.assign(1,std::vector<int>());vv.assign(1,std::vector<double>());
+			bool pt=false;
+			parse_text(s,s+len,ps,vid[0],vv[0],pt);
+			part[0]=pt;nt=1;
+		}
+		if(part[0]) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	}
+	free(s);
+
+	// Gather the pieces into one array of IDs and one array for each
+	// coordinate and the radii
+	std::vector<int> off(nt+1,0);
+	for(t=0;t<nt;t++) off[t+1]=off[t]+vid[t].size();
+	n=off[nt];
+	tid.resize(n);tv.resize(ps*n);
+#pragma omp parallel for num_threads(nt)
+	for(t=0;t<nt;t++) {
+		int i,j,m=vid[t].size();
+		for(i=0;i<m;i++) {
+			tid[off[t]+i]=vid[t][i];
+			for(j=0;j<ps;j++) tv[j*n+off[t]+i]=vv[t][ps*i+j];
+		}
+	}
+	set_text_pointers(ps);
+}
+
+/** Parses a piece of a text particle file.
+ * \param[in] (s,e) pointers to the start and end of the piece.
+ * \param[in] ps the number of floating point values per particle.
+ * \param[out] vid the particle IDs.
+ * \param[out] vv the floating point values, stored together for each particle.
+ * \param[out] part set to true if the piece ends within a particle. */
+void particle_import::parse_text(const char *s,const char *e,int ps,std::vector<int> &vid,std::vector<double> &vv,bool &part) {
+	char *q;
+	double d[4];
+	int i,j;
+	while(true) {
+		while(s<e&&isspace((unsigned char) *s)) s++;
+		if(s==e) return;
+		i=int(strtol(s,&q,10));
+		if(q==s) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+		s=q;
+		for(j=0;j<ps;j++) {
+			while(s<e&&isspace((unsigned char) *s)) s++;
+			if(s==e) {part=true;return;}
+			d[j]=strtod(s,&q);
+			if(q==s) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+			s=q;
+		}
+		vid.push_back(i);
+		for(j=0;j<ps;j++) vv.push_back(d[j]);
+	}
+}
+
+/** Sets the array pointers to the storage for a text file.
+ * \param[in] ps the number of floating point values per particle. */
+void particle_import::set_text_pointers(int ps) {
+	if(n==0) return;
+	id=&tid[0];
+	x=&tv[0];y=x+n;z=y+n;
+	r=ps==4?z+n:NULL;
+}
+
+/** Writes particles to a file in the binary particle format.
+ * \param[in] filename the name of the file to write.
+ * \param[in] n the number of particles.
+ * \param[in] id the particle IDs.
+ * \param[in] (x,y,z) the particle coordinates.
+ * \param[in] r the particle radii, or NULL if they should not be written. */
+void write_particles_binary(const char *filename,int n,const int *id,const double *x,const double *y,const double *z,const double *r) {
+	FILE *fp=safe_fopen(filename,"wb");
+	int h[4]={binary_version,r!=NULL?1:0,n,0},pad=0;
+	size_t pl=((sizeof(int)*n+7)&~((size_t) 7))-sizeof(int)*n;
+	if(fwrite(binary_magic,1,8,fp)!=8||fwrite(h,sizeof(int),4,fp)!=4
+	 ||fwrite(id,sizeof(int),n,fp)!=(size_t) n||fwrite(&pad,1,pl,fp)!=pl
+	 ||fwrite(x,sizeof(double),n,fp)!=(size_t) n||fwrite(y,sizeof(double),n,fp)!=(size_t) n
+	 ||fwrite(z,sizeof(double),n,fp)!=(size_t) n||(r!=NULL&&fwrite(r,sizeof(double),n,fp)!=(size_t) n))
+		voro_fatal_error("File output error",VOROPP_FILE_ERROR);
+	fclose(fp);
+}
+
+}
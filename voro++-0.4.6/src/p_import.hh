@@ -0,0 +1,83 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_import.hh
+ * \brief Header file for the particle_import class, which reads particle files
+ * in bulk. */
+
+#ifndef VOROPP_P_IMPORT_HH
+#define VOROPP_P_IMPORT_HH
+
+#include <cstdio>
+#include <vector>
+
+#include "config.hh"
+
+namespace voro {
+
+/** \brief A class for reading a whole particle file into flat arrays.
+ *
+ * This class reads a particle file into separate arrays of IDs, coordinates,
+ * and optionally radii, which can be passed directly to the put_all routines
+ * of the container classes. Two formats are supported. The text format is the
+ * one read by the import routines of the containers, with four or five numbers
+ * per particle, and it is parsed on several threads. The binary format
+ * consists of a 24-byte header holding the eight characters "VORO++B" followed
+ * by a zero byte, the format version, a flags word whose lowest bit is set if
+ * radii are present, the number of particles n, and a reserved word, all as
+ * 32-bit integers. It is followed by n 32-bit IDs, padded to a multiple of
+ * eight bytes, and then by n doubles each for the x, y, and z coordinates and
+ * for the radii if present. All numbers use the byte order of the machine.
+ * Binary files are memory mapped where this is available, so that the arrays
+ * point straight into the file. */
+class particle_import {
+	public:
+		/** The number of particles. */
+		int n;
+		/** Whether radii are available. */
+		bool radii;
+		/** The particle IDs. */
+		const int *id;
+		/** The x coordinates of the particles. */
+		const double *x;
+		/** The y coordinates of the particles. */
+		const double *y;
+		/** The z coordinates of the particles. */
+		const double *z;
+		/** The radii of the particles, or NULL if there are none. */
+		const double *r;
+		particle_import();
+		~particle_import();
+		void load(const char *filename,bool radii_,int threads=0);
+		void load_binary(const char *filename);
+		void load_text(const char *filename,bool radii_,int threads=0);
+		void clear();
+		static bool is_binary(const char *filename);
+	private:
+		/** The start of the memory mapped or read-in binary file, or
+		 * NULL if no binary file is loaded. */
+		char *buf;
+		/** The length of the binary file. */
+		size_t buf_len;
+		/** Whether buf is memory mapped, rather than allocated. */
+		bool mapped;
+		/** Storage for the IDs read from a text file. */
+		std::vector<int> tid;
+		/** Storage for the floating point values read from a text
+		 * file, holding each of the coordinate and radius arrays in
+		 * turn. */
+		std::vector<double> tv;
+		void parse_text(const char *s,const char *e,int ps,std::vector<int> &vid,std::vector<double> &vv,bool &part);
+		void set_text_pointers(int ps);
+		particle_import(const particle_import&);
+		void operator=(const particle_import&);
+};
+
+void write_particles_binary(const char *filename,int n,const int *id,const double *x,const double *y,const double *z,const double *r=NULL);
+
+}
+
+#endif
@@ -12,6 +12,7 @@
 
 #include "config.hh"
 #include "pre_container.hh"
+#include "p_import.hh"
 
 namespace voro {
 
@@ -94,46 +95,85 @@ void pre_container_poly::put(int n,double x,double y,double z,double r) {
 #endif
 }
 
-/** Transfers the particles stored within the class to a container class.
+/** Stores an array of particle IDs and positions, filling each memory chunk
+ * in turn. Particles that are out of bounds are skipped, as in the put
+ * routine.
+ * \param[in] ids the numerical IDs of the inserted particles.
+ * \param[in] (xs,ys,zs) the position vectors of the inserted particles.
+ * \param[in] n the number of particles. */
+void pre_container::put_all(const int *ids,const double *xs,const double *ys,const double *zs,int n) {
+	for(int l=0;l<n;l++) {
+		double x=xs[l],y=ys[l],z=zs[l];
+		if((xperiodic||(x>=ax&&x<=bx))&&(yperiodic||(y>=ay&&y<=by))&&(zperiodic||(z>=az&&z<=bz))) {
+			if(ch_id==e_id) new_chunk();
+			*(ch_id++)=ids[l];
+			*(ch_p++)=x;*(ch_p++)=y;*(ch_p++)=z;
+		}
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+		else fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",x,y,z);
+#endif
+	}
+}
+
+/** Stores an array of particle IDs, positions and radii, filling each memory
+ * chunk in turn. Particles that are out of bounds are skipped, as in the put
+ * routine.
+ * \param[in] ids the numerical IDs of the inserted particles.
+ * \param[in] (xs,ys,zs) the position vectors of the inserted particles.
+ * \param[in] rs the radii of the inserted particles.
+ * \param[in] n the number of particles. */
+void pre_container_poly::put_all(const int *ids,const double *xs,const double *ys,const double *zs,const double *rs,int n) {
+	for(int l=0;l<n;l++) {
+		double x=xs[l],y=ys[l],z=zs[l];
+		if((xperiodic||(x>=ax&&x<=bx))&&(yperiodic||(y>=ay&&y<=by))&&(zperiodic||(z>=az&&z<=bz))) {
+			if(ch_id==e_id) new_chunk();
+			*(ch_id++)=ids[l];
+			*(ch_p++)=x;*(ch_p++)=y;*(ch_p++)=z;*(ch_p++)=rs[l];
+		}
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+		else fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",x,y,z);
+#endif
+	}
+}
+
+/** Transfers the particles stored within the class to a container class. The
+ * particles are gathered into separate arrays and put into the container with
+ * a single put_all call, so that every block is allocated once.
  * \param[in] con the container class to transfer to. */
 void pre_container::setup(container &con) {
-	int **c_id=pre_id,*idp,*ide,n;
-	double **c_p=pre_p,*pp,x,y,z;
-	while(c_id<end_id) {
-		idp=*(c_id++);ide=idp+pre_container_chunk_size;
+	int tp=total_particles(),*ids=new int[tp],**c_id=pre_id,*idp,*ide,*ip=ids;
+	double *xs=new double[3*tp],*ys=xs+tp,*zs=ys+tp,**c_p=pre_p,*pp;
+	while(c_id<=end_id) {
+		idp=*(c_id++);ide=c_id<=end_id?idp+pre_container_chunk_size:ch_id;
 		pp=*(c_p++);
 		while(idp<ide) {
-			n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);
-			con.put(n,x,y,z);
+			*(ip++)=*(idp++);*(xs++)=*(pp++);*(ys++)=*(pp++);*(zs++)=*(pp++);
 		}
 	}
-	idp=*c_id;
-	pp=*c_p;
-	while(idp<ch_id) {
-		n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);
-		con.put(n,x,y,z);
-	}
+	xs-=tp;ys-=tp;zs-=tp;
+	con.put_all(ids,xs,ys,zs,tp);
+	delete [] xs;
+	delete [] ids;
 }
 
 /** Transfers the particles stored within the class to a container_poly class.
+ * The particles are gathered into separate arrays and put into the container
+ * with a single put_all call, so that every block is allocated once.
  * \param[in] con the container_poly class to transfer to. */
 void pre_container_poly::setup(container_poly &con) {
-	int **c_id=pre_id,*idp,*ide,n;
-	double **c_p=pre_p,*pp,x,y,z,r;
-	while(c_id<end_id) {
-		idp=*(c_id++);ide=idp+pre_container_chunk_size;
+	int tp=total_particles(),*ids=new int[tp],**c_id=pre_id,*idp,*ide,*ip=ids;
+	double *xs=new double[4*tp],*ys=xs+tp,*zs=ys+tp,*rs=zs+tp,**c_p=pre_p,*pp;
+	while(c_id<=end_id) {
+		idp=*(c_id++);ide=c_id<=end_id?idp+pre_container_chunk_size:ch_id;
 		pp=*(c_p++);
 		while(idp<ide) {
-			n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);r=*(pp++);
-			con.put(n,x,y,z,r);
+			*(ip++)=*(idp++);*(xs++)=*(pp++);*(ys++)=*(pp++);*(zs++)=*(pp++);*(rs++)=*(pp++);
 		}
 	}
-	idp=*c_id;
-	pp=*c_p;
-	while(idp<ch_id) {
-		n=*(idp++);x=*(pp++);y=*(pp++);z=*(pp++);r=*(pp++);
-		con.put(n,x,y,z,r);
-	}
+	xs-=tp;ys-=tp;zs-=tp;rs-=tp;
+	con.put_all(ids,xs,ys,zs,rs,tp);
+	delete [] xs;
+	delete [] ids;
 }
 
 /** Transfers the particles stored within the class to a container class, also
@@ -194,6 +234,18 @@ void pre_container::import(FILE *fp) {
 	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
 }
 
+/** Imports a whole particle file, which may be in the text format read by the
+ * import routine, parsed on several threads, or in the binary format of the
+ * particle_import class, which is memory mapped.
+ * \param[in] filename the name of the file to read.
+ * \param[in] threads the number of threads to parse a text file on, or zero
+ *                    for the OpenMP default. */
+void pre_container::import_bulk(const char *filename,int threads) {
+	particle_import pi;
+	pi.load(filename,false,threads);
+	put_all(pi.id,pi.x,pi.y,pi.z,pi.n);
+}
+
 /** Import a list of particles from an open file stream, also storing the order
  * of that the particles are read. Entries of four numbers (Particle ID, x
  * position, y position, z position) are searched for. If the file cannot be
@@ -206,6 +258,18 @@ void pre_container_poly::import(FILE *fp) {
 	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
 }
 
+/** Imports a whole particle file, which may be in the text format read by the
+ * import routine, parsed on several threads, or in the binary format of the
+ * particle_import class, which is memory mapped and must hold radii.
+ * \param[in] filename the name of the file to read.
+ * \param[in] threads the number of threads to parse a text file on, or zero
+ *                    for the OpenMP default. */
+void pre_container_poly::import_bulk(const char *filename,int threads) {
+	particle_import pi;
+	pi.load(filename,true,threads);
+	put_all(pi.id,pi.x,pi.y,pi.z,pi.r,pi.n);
+}
+
 /** Allocates a new chunk of memory for storing particles. */
 void pre_container_base::new_chunk() {
 	end_id++;end_p++;
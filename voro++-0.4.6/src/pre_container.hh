@@ -113,7 +113,9 @@ class pre_container : public pre_container_base {
 				bool xperiodic_,bool yperiodic_,bool zperiodic_)
 			: pre_container_base(ax_,bx_,ay_,by_,az_,bz_,xperiodic_,yperiodic_,zperiodic_,3) {};
 		void put(int n,double x,double y,double z);
+		void put_all(const int *ids,const double *xs,const double *ys,const double *zs,int n);
 		void import(FILE *fp=stdin);
+		void import_bulk(const char *filename,int threads=0);
 		/** Imports particles from a file.
 		 * \param[in] filename the name of the file to read from. */
 		inline void import(const char* filename) {
@@ -145,7 +147,9 @@ class pre_container_poly : public pre_container_base {
 				bool xperiodic_,bool yperiodic_,bool zperiodic_)
 			: pre_container_base(ax_,bx_,ay_,by_,az_,bz_,xperiodic_,yperiodic_,zperiodic_,4) {};
 		void put(int n,double x,double y,double z,double r);
+		void put_all(const int *ids,const double *xs,const double *ys,const double *zs,const double *rs,int n);
 		void import(FILE *fp=stdin);
+		void import_bulk(const char *filename,int threads=0);
 		/** Imports particles from a file.
 		 * \param[in] filename the name of the file to read from. */
 		inline void import(const char* filename) {
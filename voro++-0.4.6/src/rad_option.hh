@@ -22,26 +22,31 @@ namespace voro {
  * and during the Voronoi cell computation, these routines are used to create
  * the regular Voronoi tessellation. */
 class radius_mono {
+	public:
+		/** Per-computation constants. None are needed for the regular
+		 * tessellation. */
+		struct r_state {};
 	protected:
 		/** This is called prior to computing a Voronoi cell for a
 		 * given particle to initialize any required constants.
+		 * \param[out] st the constants of the computation.
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] s the index of the particle within the block. */
-		inline void r_init(int ijk,int s) {}
+		inline void r_init(r_state &st,int ijk,int s) {}
 		/** Sets a required constant to be used when carrying out a
 		 * plane bounds check. */
-		inline void r_prime(double rv) {}
+		inline void r_prime(r_state &st,double rv) {}
 		/** Carries out a radius bounds check.
 		 * \param[in] crs the radius squared to be tested.
 		 * \param[in] mrs the current maximum distance to a Voronoi
 		 *                vertex multiplied by two.
 		 * \return True if particles at this radius could not possibly
 		 * cut the cell, false otherwise. */
-		inline bool r_ctest(double crs,double mrs) {return crs>mrs;}
+		inline bool r_ctest(r_state &st,double crs,double mrs) {return crs>mrs;}
 		/** Scales a plane displacement during a plane bounds check.
 		 * \param[in] lrs the plane displacement.
 		 * \return The scaled value. */
-		inline double r_cutoff(double lrs) {return lrs;}
+		inline double r_cutoff(r_state &st,double lrs) {return lrs;}
 		/** Adds the maximum radius squared to a given value.
 		 * \param[in] rs the value to consider.
 		 * \return The value with the radius squared added. */
@@ -59,7 +64,7 @@ class radius_mono {
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] q the index of the particle within the block.
 		 * \return The scaled plane displacement. */ 
-		inline double r_scale(double rs,int ijk,int q) {return rs;}
+		inline double r_scale(r_state &st,double rs,int ijk,int q) {return rs;}
 		/** Scales a plane displacement prior to use in the plane
 		 * cutting algorithm, and also checks if it could possibly cut
 		 * the cell.
@@ -70,7 +75,7 @@ class radius_mono {
 		 * \param[in] q the index of the particle within the block.
 		 * \return True if the cell could possibly cut the cell, false
 		 * otherwise. */		
-		inline bool r_scale_check(double &rs,double mrs,int ijk,int q) {return rs<mrs;}
+		inline bool r_scale_check(r_state &st,double &rs,double mrs,int ijk,int q) {return rs<mrs;}
 };
 
 /**  \brief Class containing all of the routines that are specific to computing 
@@ -90,29 +95,36 @@ class radius_poly {
 		/** The class constructor sets the maximum particle radius to
 		 * be zero. */
 		radius_poly() : max_radius(0) {}
+		/** Per-computation constants. They are kept by the
+		 * computing class rather than the container, so that several
+		 * cells can be computed at the same time. */
+		struct r_state {
+			double r_rad,r_mul,r_val;
+		};
 	protected:
 		/** This is called prior to computing a Voronoi cell for a
 		 * given particle to initialize any required constants.
+		 * \param[out] st the constants of the computation.
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] s the index of the particle within the block. */
-		inline void r_init(int ijk,int s) {
-			r_rad=ppr[ijk][4*s+3]*ppr[ijk][4*s+3];
-			r_mul=r_rad-max_radius*max_radius;
+		inline void r_init(r_state &st,int ijk,int s) {
+			st.r_rad=ppr[ijk][4*s+3]*ppr[ijk][4*s+3];
+			st.r_mul=st.r_rad-max_radius*max_radius;
 		}
 		/** Sets a required constant to be used when carrying out a
 		 * plane bounds check. */
-		inline void r_prime(double rv) {r_val=1+r_mul/rv;}
+		inline void r_prime(r_state &st,double rv) {st.r_val=1+st.r_mul/rv;}
 		/** Carries out a radius bounds check.
 		 * \param[in] crs the radius squared to be tested.
 		 * \param[in] mrs the current maximum distance to a Voronoi
 		 *                vertex multiplied by two.
 		 * \return True if particles at this radius could not possibly
 		 * cut the cell, false otherwise. */		
-		inline bool r_ctest(double crs,double mrs) {return crs+r_mul>sqrt(mrs*crs);}
+		inline bool r_ctest(r_state &st,double crs,double mrs) {return crs+st.r_mul>sqrt(mrs*crs);}
 		/** Scales a plane displacement during a plane bounds check.
 		 * \param[in] lrs the plane displacement.
 		 * \return The scaled value. */		
-		inline double r_cutoff(double lrs) {return lrs*r_val;}
+		inline double r_cutoff(r_state &st,double lrs) {return lrs*st.r_val;}
 		/** Adds the maximum radius squared to a given value.
 		 * \param[in] rs the value to consider.
 		 * \return The value with the radius squared added. */		
@@ -132,8 +144,8 @@ class radius_poly {
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] q the index of the particle within the block.
 		 * \return The scaled plane displacement. */ 
-		inline double r_scale(double rs,int ijk,int q) {
-			return rs+r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+		inline double r_scale(r_state &st,double rs,int ijk,int q) {
+			return rs+st.r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
 		}
 		/** Scales a plane displacement prior to use in the plane
 		 * cutting algorithm, and also checks if it could possibly cut
@@ -145,13 +157,11 @@ class radius_poly {
 		 * \param[in] q the index of the particle within the block.
 		 * \return True if the cell could possibly cut the cell, false
 		 * otherwise. */
-		inline bool r_scale_check(double &rs,double mrs,int ijk,int q) {
+		inline bool r_scale_check(r_state &st,double &rs,double mrs,int ijk,int q) {
 			double trs=rs;
-			rs+=r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+			rs+=st.r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
 			return rs<sqrt(mrs*trs);
 		}
-	private:
-		double r_rad,r_mul,r_val;
 };
 
 }
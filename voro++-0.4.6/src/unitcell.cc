@@ -63,9 +63,9 @@ unitcell::unitcell(double bx_,double bxy_,double by_,double bxz_,double byz_,dou
 			// than the one based on computing the maximum radius
 			// of a Voronoi cell vertex.
 			max_uv_y=max_uv_z=0;
-			double y,z,q,*pts=unit_voro.pts,*pp=pts;
-			while(pp<pts+3*unit_voro.p) {
-				q=*(pp++);y=*(pp++);z=*(pp++);q=sqrt(q*q+y*y+z*z);
+			double y,z,q;
+			for(int i=0;i<unit_voro.p;i++) {
+				q=unit_voro.pt(i,0);y=unit_voro.pt(i,1);z=unit_voro.pt(i,2);q=sqrt(q*q+y*y+z*z);
 				if(y+q>max_uv_y) max_uv_y=y+q;
 				if(z+q>max_uv_z) max_uv_z=z+q;
 			}
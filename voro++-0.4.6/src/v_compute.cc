@@ -64,21 +64,34 @@ inline void voro_compute<c_class>::scan_all(int ijk,double x,double y,double z,i
  * \param[in] (ci,cj,ck) the coordinates of the block that the test particle is
  *                       in relative to the container data structure.
  * \param[in] ijk the index of the block that the test particle is in.
- * \param[out] w a reference to a particle record in which to store information
- * 		 about the particle whose Voronoi cell the vector is within.
- * \param[out] mrs the minimum computed distance. */
+ * \param[in,out] w a reference to a particle record in which to store
+ *		    information about the particle whose Voronoi cell the
+ *		    vector is within.
+ * \param[out] mrs the minimum computed distance.
+ * \param[in] seeded whether w already holds a particle that was found for
+ *		     another vector in the same block. Its distance to this
+ *		     vector then serves as an upper bound to prune the
+ *		     search. */
 template<class c_class>
-void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,int cj,int ck,int ijk,particle_record &w,double &mrs) {
+void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,int cj,int ck,int ijk,particle_record &w,double &mrs,bool seeded) {
 	double qx=0,qy=0,qz=0,rs;
 	int i,j,k,di,dj,dk,ei,ej,ek,f,g,disp;
 	double fx,fy,fz,mxs,mys,mzs,*radp;
 	unsigned int q,*e,*mijk;
 
-	// Init setup for parameters to return
-	w.ijk=-1;mrs=large_number;
-
 	con.initialize_search(ci,cj,ck,ijk,i,j,k,disp);
 
+	// Init setup for parameters to return, or compute the distance to the
+	// seed particle, which lies in the same relative block as before
+	if(seeded) {
+		con.region_index(ci,cj,ck,i+w.di,j+w.dj,k+w.dk,qx,qy,qz,disp);
+		fx=p[w.ijk][ps*w.l]-x+qx;
+		fy=p[w.ijk][ps*w.l+1]-y+qy;
+		fz=p[w.ijk][ps*w.l+2]-z+qz;
+		mrs=con.r_current_sub(fx*fx+fy*fy+fz*fz,w.ijk,w.l);
+		qx=qy=qz=0;
+	} else {w.ijk=-1;mrs=large_number;}
+
 	// Test all particles in the particle's local region first
 	scan_all(ijk,x,y,z,0,0,0,w,mrs);
 
@@ -297,7 +310,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 	unsigned int q,*e,*mijk;
 
 	if(!con.initialize_voronoicell(c,ijk,s,ci,cj,ck,i,j,k,x,y,z,disp)) return false;
-	con.r_init(ijk,s);
+	con.r_init(rst,ijk,s);
 
 	// Initialize the Voronoi cell to fill the entire container
 	double crs,mrs;
@@ -309,7 +322,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		x1=p[ijk][ps*l]-x;
 		y1=p[ijk][ps*l+1]-y;
 		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+		rs=con.r_scale(rst,x1*x1+y1*y1+z1*z1,ijk,l);
 		if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 	}
 	l++;
@@ -317,7 +330,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		x1=p[ijk][ps*l]-x;
 		y1=p[ijk][ps*l+1]-y;
 		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+		rs=con.r_scale(rst,x1*x1+y1*y1+z1*z1,ijk,l);
 		if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 		l++;
 	}
@@ -375,7 +388,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_ctest(radp[g],mrs)) return true;
+		if(con.r_ctest(rst,radp[g],mrs)) return true;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -408,12 +421,12 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		// those particles which can't possibly intersect the block.
 		if(co[ijk]>0) {
 			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
-			if(!con.r_ctest(crs,mrs)) {
+			if(!con.r_ctest(rst,crs,mrs)) {
 				do {
 					x1=p[ijk][ps*l]-x2;
 					y1=p[ijk][ps*l+1]-y2;
 					z1=p[ijk][ps*l+2]-z2;
-					rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+					rs=con.r_scale(rst,x1*x1+y1*y1+z1*z1,ijk,l);
 					if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
@@ -423,7 +436,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 					y1=p[ijk][ps*l+1]-y2;
 					z1=p[ijk][ps*l+2]-z2;
 					rs=x1*x1+y1*y1+z1*z1;
-					if(con.r_scale_check(rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+					if(con.r_scale_check(rst,rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
 			}
@@ -457,7 +470,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_ctest(radp[g],mrs)) return true;
+		if(con.r_ctest(rst,radp[g],mrs)) return true;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -494,12 +507,12 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		// those particles which can't possibly intersect the block.
 		if(co[ijk]>0) {
 			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
-			if(!con.r_ctest(crs,mrs)) {
+			if(!con.r_ctest(rst,crs,mrs)) {
 				do {
 					x1=p[ijk][ps*l]-x2;
 					y1=p[ijk][ps*l+1]-y2;
 					z1=p[ijk][ps*l+2]-z2;
-					rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+					rs=con.r_scale(rst,x1*x1+y1*y1+z1*z1,ijk,l);
 					if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
@@ -509,7 +522,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 					y1=p[ijk][ps*l+1]-y2;
 					z1=p[ijk][ps*l+2]-z2;
 					rs=x1*x1+y1*y1+z1*z1;
-					if(con.r_scale_check(rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
+					if(con.r_scale_check(rst,rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 					l++;
 				} while (l<co[ijk]);
 			}
@@ -526,7 +539,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 	}
 
 	// Do a check to see if we've reached the radius cutoff
-	if(con.r_ctest(radp[g],mrs)) return true;
+	if(con.r_ctest(rst,radp[g],mrs)) return true;
 
 	// We were unable to completely compute the cell based on the blocks in
 	// the worklist, so now we have to go block by block, reading in items
@@ -603,7 +616,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 				x1=p[ijk][ps*l]-x2;
 				y1=p[ijk][ps*l+1]-y2;
 				z1=p[ijk][ps*l+2]-z2;
-				rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
+				rs=con.r_scale(rst,x1*x1+y1*y1+z1*z1,ijk,l);
 				if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
 				l++;
 			} while (l<co[ijk]);
@@ -632,13 +645,13 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 template<class c_class>
 template<class v_cell>
 bool voro_compute<c_class>::corner_test(v_cell &c,double xl,double yl,double zl,double xh,double yh,double zh) {
-	con.r_prime(xl*xl+yl*yl+zl*zl);
-	if(c.plane_intersects_guess(xh,yl,zl,con.r_cutoff(xl*xh+yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(xh,yh,zl,con.r_cutoff(xl*xh+yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(xl,yh,zl,con.r_cutoff(xl*xl+yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(xl,yh,zh,con.r_cutoff(xl*xl+yl*yh+zl*zh))) return false;
-	if(c.plane_intersects(xl,yl,zh,con.r_cutoff(xl*xl+yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(xh,yl,zh,con.r_cutoff(xl*xh+yl*yl+zl*zh))) return false;
+	con.r_prime(rst,xl*xl+yl*yl+zl*zl);
+	if(c.plane_intersects_guess(xh,yl,zl,con.r_cutoff(rst,xl*xh+yl*yl+zl*zl))) return false;
+	if(c.plane_intersects(xh,yh,zl,con.r_cutoff(rst,xl*xh+yl*yh+zl*zl))) return false;
+	if(c.plane_intersects(xl,yh,zl,con.r_cutoff(rst,xl*xl+yl*yh+zl*zl))) return false;
+	if(c.plane_intersects(xl,yh,zh,con.r_cutoff(rst,xl*xl+yl*yh+zl*zh))) return false;
+	if(c.plane_intersects(xl,yl,zh,con.r_cutoff(rst,xl*xl+yl*yl+zl*zh))) return false;
+	if(c.plane_intersects(xh,yl,zh,con.r_cutoff(rst,xl*xh+yl*yl+zl*zh))) return false;
 	return true;
 }
 
@@ -657,13 +670,13 @@ bool voro_compute<c_class>::corner_test(v_cell &c,double xl,double yl,double zl,
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::edge_x_test(v_cell &c,double x0,double yl,double zl,double x1,double yh,double zh) {
-	con.r_prime(yl*yl+zl*zl);
-	if(c.plane_intersects_guess(x0,yl,zh,con.r_cutoff(yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(x1,yl,zh,con.r_cutoff(yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(x1,yl,zl,con.r_cutoff(yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(x0,yl,zl,con.r_cutoff(yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(x0,yh,zl,con.r_cutoff(yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(x1,yh,zl,con.r_cutoff(yl*yh+zl*zl))) return false;
+	con.r_prime(rst,yl*yl+zl*zl);
+	if(c.plane_intersects_guess(x0,yl,zh,con.r_cutoff(rst,yl*yl+zl*zh))) return false;
+	if(c.plane_intersects(x1,yl,zh,con.r_cutoff(rst,yl*yl+zl*zh))) return false;
+	if(c.plane_intersects(x1,yl,zl,con.r_cutoff(rst,yl*yl+zl*zl))) return false;
+	if(c.plane_intersects(x0,yl,zl,con.r_cutoff(rst,yl*yl+zl*zl))) return false;
+	if(c.plane_intersects(x0,yh,zl,con.r_cutoff(rst,yl*yh+zl*zl))) return false;
+	if(c.plane_intersects(x1,yh,zl,con.r_cutoff(rst,yl*yh+zl*zl))) return false;
 	return true;
 }
 
@@ -682,13 +695,13 @@ inline bool voro_compute<c_class>::edge_x_test(v_cell &c,double x0,double yl,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::edge_y_test(v_cell &c,double xl,double y0,double zl,double xh,double y1,double zh) {
-	con.r_prime(xl*xl+zl*zl);
-	if(c.plane_intersects_guess(xl,y0,zh,con.r_cutoff(xl*xl+zl*zh))) return false;
-	if(c.plane_intersects(xl,y1,zh,con.r_cutoff(xl*xl+zl*zh))) return false;
-	if(c.plane_intersects(xl,y1,zl,con.r_cutoff(xl*xl+zl*zl))) return false;
-	if(c.plane_intersects(xl,y0,zl,con.r_cutoff(xl*xl+zl*zl))) return false;
-	if(c.plane_intersects(xh,y0,zl,con.r_cutoff(xl*xh+zl*zl))) return false;
-	if(c.plane_intersects(xh,y1,zl,con.r_cutoff(xl*xh+zl*zl))) return false;
+	con.r_prime(rst,xl*xl+zl*zl);
+	if(c.plane_intersects_guess(xl,y0,zh,con.r_cutoff(rst,xl*xl+zl*zh))) return false;
+	if(c.plane_intersects(xl,y1,zh,con.r_cutoff(rst,xl*xl+zl*zh))) return false;
+	if(c.plane_intersects(xl,y1,zl,con.r_cutoff(rst,xl*xl+zl*zl))) return false;
+	if(c.plane_intersects(xl,y0,zl,con.r_cutoff(rst,xl*xl+zl*zl))) return false;
+	if(c.plane_intersects(xh,y0,zl,con.r_cutoff(rst,xl*xh+zl*zl))) return false;
+	if(c.plane_intersects(xh,y1,zl,con.r_cutoff(rst,xl*xh+zl*zl))) return false;
 	return true;
 }
 
@@ -706,13 +719,13 @@ inline bool voro_compute<c_class>::edge_y_test(v_cell &c,double xl,double y0,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::edge_z_test(v_cell &c,double xl,double yl,double z0,double xh,double yh,double z1) {
-	con.r_prime(xl*xl+yl*yl);
-	if(c.plane_intersects_guess(xl,yh,z0,con.r_cutoff(xl*xl+yl*yh))) return false;
-	if(c.plane_intersects(xl,yh,z1,con.r_cutoff(xl*xl+yl*yh))) return false;
-	if(c.plane_intersects(xl,yl,z1,con.r_cutoff(xl*xl+yl*yl))) return false;
-	if(c.plane_intersects(xl,yl,z0,con.r_cutoff(xl*xl+yl*yl))) return false;
-	if(c.plane_intersects(xh,yl,z0,con.r_cutoff(xl*xh+yl*yl))) return false;
-	if(c.plane_intersects(xh,yl,z1,con.r_cutoff(xl*xh+yl*yl))) return false;
+	con.r_prime(rst,xl*xl+yl*yl);
+	if(c.plane_intersects_guess(xl,yh,z0,con.r_cutoff(rst,xl*xl+yl*yh))) return false;
+	if(c.plane_intersects(xl,yh,z1,con.r_cutoff(rst,xl*xl+yl*yh))) return false;
+	if(c.plane_intersects(xl,yl,z1,con.r_cutoff(rst,xl*xl+yl*yl))) return false;
+	if(c.plane_intersects(xl,yl,z0,con.r_cutoff(rst,xl*xl+yl*yl))) return false;
+	if(c.plane_intersects(xh,yl,z0,con.r_cutoff(rst,xl*xh+yl*yl))) return false;
+	if(c.plane_intersects(xh,yl,z1,con.r_cutoff(rst,xl*xh+yl*yl))) return false;
 	return true;
 }
 
@@ -729,11 +742,11 @@ inline bool voro_compute<c_class>::edge_z_test(v_cell &c,double xl,double yl,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::face_x_test(v_cell &c,double xl,double y0,double z0,double y1,double z1) {
-	con.r_prime(xl*xl);
-	if(c.plane_intersects_guess(xl,y0,z0,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y0,z1,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y1,z1,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y1,z0,con.r_cutoff(xl*xl))) return false;
+	con.r_prime(rst,xl*xl);
+	if(c.plane_intersects_guess(xl,y0,z0,con.r_cutoff(rst,xl*xl))) return false;
+	if(c.plane_intersects(xl,y0,z1,con.r_cutoff(rst,xl*xl))) return false;
+	if(c.plane_intersects(xl,y1,z1,con.r_cutoff(rst,xl*xl))) return false;
+	if(c.plane_intersects(xl,y1,z0,con.r_cutoff(rst,xl*xl))) return false;
 	return true;
 }
 
@@ -750,11 +763,11 @@ inline bool voro_compute<c_class>::face_x_test(v_cell &c,double xl,double y0,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::face_y_test(v_cell &c,double x0,double yl,double z0,double x1,double z1) {
-	con.r_prime(yl*yl);
-	if(c.plane_intersects_guess(x0,yl,z0,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x0,yl,z1,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x1,yl,z1,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x1,yl,z0,con.r_cutoff(yl*yl))) return false;
+	con.r_prime(rst,yl*yl);
+	if(c.plane_intersects_guess(x0,yl,z0,con.r_cutoff(rst,yl*yl))) return false;
+	if(c.plane_intersects(x0,yl,z1,con.r_cutoff(rst,yl*yl))) return false;
+	if(c.plane_intersects(x1,yl,z1,con.r_cutoff(rst,yl*yl))) return false;
+	if(c.plane_intersects(x1,yl,z0,con.r_cutoff(rst,yl*yl))) return false;
 	return true;
 }
 
@@ -771,11 +784,11 @@ inline bool voro_compute<c_class>::face_y_test(v_cell &c,double x0,double yl,dou
 template<class c_class>
 template<class v_cell>
 inline bool voro_compute<c_class>::face_z_test(v_cell &c,double x0,double y0,double zl,double x1,double y1) {
-	con.r_prime(zl*zl);
-	if(c.plane_intersects_guess(x0,y0,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x0,y1,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x1,y1,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x1,y0,zl,con.r_cutoff(zl*zl))) return false;
+	con.r_prime(rst,zl*zl);
+	if(c.plane_intersects_guess(x0,y0,zl,con.r_cutoff(rst,zl*zl))) return false;
+	if(c.plane_intersects(x0,y1,zl,con.r_cutoff(rst,zl*zl))) return false;
+	if(c.plane_intersects(x1,y1,zl,con.r_cutoff(rst,zl*zl))) return false;
+	if(c.plane_intersects(x1,y0,zl,con.r_cutoff(rst,zl*zl))) return false;
 	return true;
 }
 
@@ -805,14 +818,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo+boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo+boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxx*(2*xlo+boxx)+boxy*(2*ylo+boxy)+gzs;
 			}
 		} else if(dj<0) {
@@ -820,27 +833,27 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo-boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(boxx*xlo-boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxx*(2*xlo+boxx)+boxy*(-2*ylo+boxy)+gzs;
 			}
 		} else {
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=gys+boxx*(2*xlo+boxx);
@@ -853,14 +866,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo+boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo+boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxx*(-2*xlo+boxx)+boxy*(2*ylo+boxy)+gzs;
 			}
 		} else if(dj<0) {
@@ -868,27 +881,27 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo-boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=bxsq+2*(-boxx*xlo-boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxx*(-2*xlo+boxx)+boxy*(-2*ylo+boxy)+gzs;
 			}
 		} else {
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=gys+boxx*(-2*xlo+boxx);
@@ -899,14 +912,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=boxy*(2*ylo+boxy);
@@ -915,23 +928,23 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=gzs;
 			}
 			crs+=boxy*(-2*ylo+boxy);
 		} else {
 			if(dk>0) {
-				zlo=dk*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				zlo=dk*boxz-fz;crs=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
-				zlo=(dk+1)*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				zlo=(dk+1)*boxz-fz;crs=zlo*zlo;if(con.r_ctest(rst,crs,mrs)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
 				crs=0;
@@ -988,19 +1001,19 @@ template voro_compute<container>::voro_compute(container&,int,int,int);
 template voro_compute<container_poly>::voro_compute(container_poly&,int,int,int);
 template bool voro_compute<container>::compute_cell(voronoicell&,int,int,int,int,int);
 template bool voro_compute<container>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
-template void voro_compute<container>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
+template void voro_compute<container>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&,bool);
 template bool voro_compute<container_poly>::compute_cell(voronoicell&,int,int,int,int,int);
 template bool voro_compute<container_poly>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
-template void voro_compute<container_poly>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
+template void voro_compute<container_poly>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&,bool);
 
 // Explicit template instantiation
 template voro_compute<container_periodic>::voro_compute(container_periodic&,int,int,int);
 template voro_compute<container_periodic_poly>::voro_compute(container_periodic_poly&,int,int,int);
 template bool voro_compute<container_periodic>::compute_cell(voronoicell&,int,int,int,int,int);
 template bool voro_compute<container_periodic>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
-template void voro_compute<container_periodic>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
+template void voro_compute<container_periodic>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&,bool);
 template bool voro_compute<container_periodic_poly>::compute_cell(voronoicell&,int,int,int,int,int);
 template bool voro_compute<container_periodic_poly>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
-template void voro_compute<container_periodic_poly>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
+template void voro_compute<container_periodic_poly>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&,bool);
 
 }
@@ -93,7 +93,7 @@ class voro_compute {
 		}
 		template<class v_cell>
 		bool compute_cell(v_cell &c,int ijk,int s,int ci,int cj,int ck);
-		void find_voronoi_cell(double x,double y,double z,int ci,int cj,int ck,int ijk,particle_record &w,double &mrs);
+		void find_voronoi_cell(double x,double y,double z,int ci,int cj,int ck,int ijk,particle_record &w,double &mrs,bool seeded=false);
 	private:
 		/** A constant set to boxx*boxx+boxy*boxy+boxz*boxz, which is
 		 * frequently used in the computation. */
@@ -117,6 +117,9 @@ class voro_compute {
 		/** A pointer to the end of the queue array, used to determine
 		 * when the queue is full. */
 		int *qu_l;
+		/** The constants of the current cell computation that depend
+		 * on the radius option of the container. */
+		typename c_class::r_state rst;
 		template<class v_cell>
 		bool corner_test(v_cell &c,double xl,double yl,double zl,double xh,double yh,double zh);
 		template<class v_cell>
@@ -17,3 +17,5 @@
 #include "v_compute.cc"
 #include "c_loops.cc"
 #include "wall.cc"
+#include "p_import.cc"
+#include "custom_format.cc"
@@ -320,14 +320,18 @@
 #include "config.hh"
 #include "common.hh"
 #include "cell.hh"
+#include "custom_format.hh"
 #include "v_base.hh"
 #include "rad_option.hh"
 #include "container.hh"
 #include "unitcell.hh"
 #include "container_prd.hh"
 #include "pre_container.hh"
+#include "p_import.hh"
 #include "v_compute.hh"
 #include "c_loops.hh"
+#include "c_parallel.hh"
+#include "c_update.hh"
 #include "wall.hh"
 
 #endif